@@ -11,20 +11,115 @@ typedef struct {
     int dirty; // 0 or 1
 } Page;
 
-// Function to find if the page is present in the frame
-bool isPagePresent(Page frames[], int frame_count, Page page) {
-    for (int i = 0; i < frame_count; i++) {
-        if (frames[i].page_number == page.page_number) {  
-            return true;
+// Allocate memory or abort the program with an error message
+void *checkedMalloc(size_t size) {
+    void *memory = malloc(size);
+    if (memory == NULL && size != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// Open-addressing hash index from page number to frame slot (linear probing)
+typedef struct {
+    int *keys;    // page number stored in each bucket, -1 marks an empty bucket
+    int *values;  // frame slot of the page stored in each bucket
+    int mask;     // bucket count - 1, the bucket count is a power of two
+    int size;     // number of pages stored
+} PageIndex;
+
+// Function to map a page number to its home bucket
+static inline int pageIndexBucket(const PageIndex *index, int page) {
+    unsigned int hash = (unsigned int)page * 2654435769u;
+    return (int)((hash ^ (hash >> 15)) & (unsigned int)index->mask);
+}
+
+// Function to allocate buckets for at least capacity pages at 50% load
+void pageIndexInit(PageIndex *index, int capacity) {
+    int buckets = 16;
+    while (buckets < 2 * capacity) {
+        buckets <<= 1;
+    }
+    index->keys = checkedMalloc(buckets * sizeof(int));
+    index->values = checkedMalloc(buckets * sizeof(int));
+    index->mask = buckets - 1;
+    index->size = 0;
+    for (int i = 0; i < buckets; i++) {
+        index->keys[i] = -1;
+    }
+}
+
+void pageIndexFree(PageIndex *index) {
+    free(index->keys);
+    free(index->values);
+}
+
+// Function to find the frame slot of a page, -1 if the page is not indexed
+static inline int pageIndexFind(const PageIndex *index, int page) {
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != -1) {
+        if (index->keys[bucket] == page) {
+            return index->values[bucket];
+        }
+        bucket = (bucket + 1) & index->mask;
+    }
+    return -1;
+}
+
+// Function to add a page that is not indexed yet, doubling the table when it gets half full
+void pageIndexInsert(PageIndex *index, int page, int value) {
+    if (2 * (index->size + 1) > index->mask + 1) {
+        PageIndex grown;
+        pageIndexInit(&grown, index->mask + 1);
+        for (int i = 0; i <= index->mask; i++) {
+            if (index->keys[i] != -1) {
+                pageIndexInsert(&grown, index->keys[i], index->values[i]);
+            }
         }
+        pageIndexFree(index);
+        *index = grown;
+    }
+
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != -1) {
+        bucket = (bucket + 1) & index->mask;
     }
-    return false;
+    index->keys[bucket] = page;
+    index->values[bucket] = value;
+    index->size++;
+}
+
+// Function to remove a page, shifting later entries of its probe run back so no tombstones are needed
+void pageIndexRemove(PageIndex *index, int page) {
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != page) {
+        if (index->keys[bucket] == -1) {
+            return; // The page is not indexed
+        }
+        bucket = (bucket + 1) & index->mask;
+    }
+
+    int hole = bucket;
+    for (int next = (hole + 1) & index->mask; index->keys[next] != -1; next = (next + 1) & index->mask) {
+        int home = pageIndexBucket(index, index->keys[next]);
+        // Move the entry into the hole unless its home bucket lies cyclically in (hole, next]
+        if (((next - home) & index->mask) >= ((next - hole) & index->mask)) {
+            index->keys[hole] = index->keys[next];
+            index->values[hole] = index->values[next];
+            hole = next;
+        }
+    }
+    index->keys[hole] = -1;
+    index->size--;
 }
 
 // FIFO Page Replacement Algorithm
 // signature contains: a list of pages read from the input file, counter that counts the number of pages, frame count for number of frames available 
+// A page -> frame hash index makes the residency check and the dirty update a single probe, the circular frame_index is the eviction order
 void FIFO(Page pages[], int count, int frame_count) {
-    Page frames[frame_count];       // creates array of frames with size of frame_count 
+    Page *frames = checkedMalloc(frame_count * sizeof(Page)); // creates array of frames with size of frame_count 
+    PageIndex index;      // Page number -> frame holding it
     int frame_index = 0;  // Index for the FIFO replacement
     int page_faults = 0;  // Count of page faults
     int writeBacks = 0;
@@ -37,49 +132,45 @@ void FIFO(Page pages[], int count, int frame_count) {
     for (int i = 0; i < frame_count; i++) {
         frames[i] = emptyPage; // fill the frame with empty pages
     }
+    pageIndexInit(&index, frame_count);
 
     for (int i = 0; i < count; i++) {
         Page current_page = pages[i];
+        int slot = pageIndexFind(&index, current_page.page_number);
 
         // Check if the current page is already in the frames
-        if (!isPagePresent(frames, frame_count, current_page)) {
+        if (slot == -1) {
             // Page fault occurs
             page_faults++;
 
-            // if a dirty page is evicted from memory, add one to writeBacks
-            if(frames[frame_index].page_number != -1 && frames[frame_index].dirty == 1){
-                writeBacks++;       
+            if (frames[frame_index].page_number != -1) {
+                // if a dirty page is evicted from memory, add one to writeBacks
+                if (frames[frame_index].dirty == 1) {
+                    writeBacks++;       
+                }
+                pageIndexRemove(&index, frames[frame_index].page_number);
             }
 
             // Replace the page using FIFO method
             frames[frame_index] = current_page;
+            pageIndexInsert(&index, current_page.page_number, frame_index);
             frame_index = (frame_index + 1) % frame_count; // Move to the next frame in a circular manner
 
-        } else {
-
+        } else if (frames[slot].dirty == 0 && current_page.dirty == 1) {
             // if the page is present, but the dirty bit is different
-            for (int j = 0; j < frame_count; j++) {
-                if(frames[j].page_number == current_page.page_number){
-                    if (frames[j].dirty == 0 && current_page.dirty ==1)    
-                        frames[j].dirty = 1;
-                        //writeBacks++;
-                }
-
-            
-            }
-
-
+            frames[slot].dirty = 1;
         }
     }
 
     // Print results for this iteration
-    printf("| %-6d | %-12d | %-11d |\n",frame_count,page_faults,writeBacks);    // Write backs not implemented yet.
+    printf("| %-6d | %-12d | %-11d |\n",frame_count,page_faults,writeBacks);
 
     
     // print the last line
     printf("+--------+--------------+-------------+\n");
        
     
+    pageIndexFree(&index);
     free(frames); // Free the frame memory
 }
 
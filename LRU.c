@@ -10,67 +10,192 @@ typedef struct {
     int dirty; 
 } Page;
 
-//Function to find if the page is in the frame
-int findPageIndex(int *frames, int frame_count, int page) {
-    for (int i = 0; i < frame_count; i++) {
-        if (frames[i] == page) {
-            return i;
+// Allocate memory or abort the program with an error message
+void *checkedMalloc(size_t size) {
+    void *memory = malloc(size);
+    if (memory == NULL && size != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// Open-addressing hash index from page number to frame slot (linear probing)
+typedef struct {
+    int *keys;    // page number stored in each bucket, -1 marks an empty bucket
+    int *values;  // frame slot of the page stored in each bucket
+    int mask;     // bucket count - 1, the bucket count is a power of two
+    int size;     // number of pages stored
+} PageIndex;
+
+// Function to map a page number to its home bucket
+static inline int pageIndexBucket(const PageIndex *index, int page) {
+    unsigned int hash = (unsigned int)page * 2654435769u;
+    return (int)((hash ^ (hash >> 15)) & (unsigned int)index->mask);
+}
+
+// Function to allocate buckets for at least capacity pages at 50% load
+void pageIndexInit(PageIndex *index, int capacity) {
+    int buckets = 16;
+    while (buckets < 2 * capacity) {
+        buckets <<= 1;
+    }
+    index->keys = checkedMalloc(buckets * sizeof(int));
+    index->values = checkedMalloc(buckets * sizeof(int));
+    index->mask = buckets - 1;
+    index->size = 0;
+    for (int i = 0; i < buckets; i++) {
+        index->keys[i] = -1;
+    }
+}
+
+void pageIndexFree(PageIndex *index) {
+    free(index->keys);
+    free(index->values);
+}
+
+// Function to find the frame slot of a page, -1 if the page is not indexed
+static inline int pageIndexFind(const PageIndex *index, int page) {
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != -1) {
+        if (index->keys[bucket] == page) {
+            return index->values[bucket];
         }
+        bucket = (bucket + 1) & index->mask;
     }
     return -1;
 }
 
-//Function to find the least recently used page index
-int findLRUIndex(int *access_time, int frame_count) {
-    int lru_index = 0;
-    for (int i = 1; i < frame_count; i++) {
-        if (access_time[i] < access_time[lru_index]) {
-            lru_index = i;
+// Function to add a page that is not indexed yet, doubling the table when it gets half full
+void pageIndexInsert(PageIndex *index, int page, int value) {
+    if (2 * (index->size + 1) > index->mask + 1) {
+        PageIndex grown;
+        pageIndexInit(&grown, index->mask + 1);
+        for (int i = 0; i <= index->mask; i++) {
+            if (index->keys[i] != -1) {
+                pageIndexInsert(&grown, index->keys[i], index->values[i]);
+            }
         }
+        pageIndexFree(index);
+        *index = grown;
     }
-    return lru_index;
+
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != -1) {
+        bucket = (bucket + 1) & index->mask;
+    }
+    index->keys[bucket] = page;
+    index->values[bucket] = value;
+    index->size++;
 }
 
+// Function to remove a page, shifting later entries of its probe run back so no tombstones are needed
+void pageIndexRemove(PageIndex *index, int page) {
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != page) {
+        if (index->keys[bucket] == -1) {
+            return; // The page is not indexed
+        }
+        bucket = (bucket + 1) & index->mask;
+    }
+
+    int hole = bucket;
+    for (int next = (hole + 1) & index->mask; index->keys[next] != -1; next = (next + 1) & index->mask) {
+        int home = pageIndexBucket(index, index->keys[next]);
+        // Move the entry into the hole unless its home bucket lies cyclically in (hole, next]
+        if (((next - home) & index->mask) >= ((next - hole) & index->mask)) {
+            index->keys[hole] = index->keys[next];
+            index->values[hole] = index->values[next];
+            hole = next;
+        }
+    }
+    index->keys[hole] = -1;
+    index->size--;
+}
+
+// Intrusive doubly linked list threaded through per-frame prev/next arrays
+typedef struct {
+    int head;  // most recently inserted frame, -1 when the list is empty
+    int tail;  // least recently inserted frame, -1 when the list is empty
+    int size;
+} FrameList;
+
+void frameListInit(FrameList *list) {
+    list->head = -1;
+    list->tail = -1;
+    list->size = 0;
+}
+
+// Function to insert a frame at the head of the list
+static inline void frameListPushFront(FrameList *list, int *prev, int *next, int frame) {
+    prev[frame] = -1;
+    next[frame] = list->head;
+    if (list->head != -1) {
+        prev[list->head] = frame;
+    } else {
+        list->tail = frame;
+    }
+    list->head = frame;
+    list->size++;
+}
+
+// Function to remove a frame from anywhere in the list
+static inline void frameListUnlink(FrameList *list, int *prev, int *next, int frame) {
+    if (prev[frame] != -1) {
+        next[prev[frame]] = next[frame];
+    } else {
+        list->head = next[frame];
+    }
+    if (next[frame] != -1) {
+        prev[next[frame]] = prev[frame];
+    } else {
+        list->tail = prev[frame];
+    }
+    list->size--;
+}
+
+// LRU Page Replacement Algorithm
+// Residency is a hash lookup and the recency order is a linked list, so every reference costs O(1)
 void LRU(Page pages[], int count, int frame_count) {
-    int *frames = (int *)malloc(frame_count * sizeof(int)); //Array for the frames
-    int *access_time = (int *)malloc(frame_count * sizeof(int)); //Array to track access time
-    int *dirty_bits = (int *)malloc(frame_count * sizeof(int)); //Array to track the dirty bits for frames
+    int *frames = checkedMalloc(frame_count * sizeof(int)); //Page held by each frame
+    int *dirty_bits = checkedMalloc(frame_count * sizeof(int)); //Array to track the dirty bits for frames
+    int *prev = checkedMalloc(frame_count * sizeof(int)); //Recency list links towards the most recently used frame
+    int *next = checkedMalloc(frame_count * sizeof(int)); //Recency list links towards the least recently used frame
+    FrameList recency; //Head is the most recently used frame, tail the least recently used
+    PageIndex index; //Page number -> frame holding it
+    int used_frames = 0; //Frames filled so far, empty frames are used before anything is evicted
     int page_faults = 0;  //number of page faults
     int writeBacks = 0;
-    int current_time = 0; //tracking the access order
 
-    //Initialize frames, access times, and dirty bits
-    for (int i = 0; i < frame_count; i++) {
-        frames[i] = -1; //Empty frame
-        access_time[i] = -1; //set frame as never been accessed
-        dirty_bits[i] = 0; //Initialize the dirty bits
-    }
+    frameListInit(&recency);
+    pageIndexInit(&index, frame_count);
 
     for (int i = 0; i < count; i++) {  //Iterate through all of the pages
         int current_page = pages[i].page_number; //Get the current page number from the list of pages
         int current_dirty = pages[i].dirty; //Get the current page dirty status
-        int page_index = findPageIndex(frames, frame_count, current_page); //Current page in the frame
+        int page_index = pageIndexFind(&index, current_page); //Current page in the frame
 
         if (page_index == -1) { //Page fault occurs
             page_faults++;
 
-            //Find the least recently used page index
-            int lru_index = findLRUIndex(access_time, frame_count);
-
-            //Check and replace if a different page is being loaded into the frame
-            if (frames[lru_index] != current_page) {
-                //Check if the frame to be replaced is dirty
-                if (frames[lru_index] != -1 && dirty_bits[lru_index] == 1) {
+            if (used_frames < frame_count) {
+                page_index = used_frames++; //Fill an empty frame
+            } else {
+                //Evict the least recently used page
+                page_index = recency.tail;
+                if (dirty_bits[page_index] == 1) {
                     writeBacks++;
                 }
-                
-                                                                                                                                                                                                    //Replace the page with the current page
-                frames[lru_index] = current_page;
-                access_time[lru_index] = current_time; //Update the access time for the new page
-                dirty_bits[lru_index] = current_dirty; //Set the dirty bit for the new page
+                pageIndexRemove(&index, frames[page_index]);
+                frameListUnlink(&recency, prev, next, page_index);
             }
+
+            //Load the current page into the frame
+            frames[page_index] = current_page;
+            dirty_bits[page_index] = current_dirty;
+            pageIndexInsert(&index, current_page, page_index);
         } else {
-            access_time[page_index] = current_time; //Update access time
+            frameListUnlink(&recency, prev, next, page_index);
 
             //Update the dirty bit 
             if (dirty_bits[page_index] == 0 && current_dirty == 1) {
@@ -78,14 +203,16 @@ void LRU(Page pages[], int count, int frame_count) {
             }
         }
 
-        current_time++;
+        frameListPushFront(&recency, prev, next, page_index); //The current page is now the most recently used
     }
 
     printf("| %-6d | %-12d | %-11d |\n", frame_count, page_faults, writeBacks);
 
+    pageIndexFree(&index);
     free(frames);
-    free(access_time);
     free(dirty_bits);
+    free(prev);
+    free(next);
 }
 
 int main() {
@@ -150,4 +277,3 @@ int main() {
 
     return 0;
 }
-                                                                                                                                                                               17,1          Top
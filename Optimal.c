@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
 
 #define MAX_PAGES 500
 
@@ -11,85 +12,239 @@ typedef struct {
     int dirty; // 0 or 1
 } Page;
 
-// Function to find if the page is present in the frame
-bool isPagePresent(Page frames[], int frame_count, Page page) {
-    for (int i = 0; i < frame_count; i++) {
-        if (frames[i].page_number == page.page_number) {
-            return true;
+// Allocate memory or abort the program with an error message
+void *checkedMalloc(size_t size) {
+    void *memory = malloc(size);
+    if (memory == NULL && size != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// Open-addressing hash index from page number to frame slot (linear probing)
+typedef struct {
+    int *keys;    // page number stored in each bucket, -1 marks an empty bucket
+    int *values;  // frame slot of the page stored in each bucket
+    int mask;     // bucket count - 1, the bucket count is a power of two
+    int size;     // number of pages stored
+} PageIndex;
+
+// Function to map a page number to its home bucket
+static inline int pageIndexBucket(const PageIndex *index, int page) {
+    unsigned int hash = (unsigned int)page * 2654435769u;
+    return (int)((hash ^ (hash >> 15)) & (unsigned int)index->mask);
+}
+
+// Function to allocate buckets for at least capacity pages at 50% load
+void pageIndexInit(PageIndex *index, int capacity) {
+    int buckets = 16;
+    while (buckets < 2 * capacity) {
+        buckets <<= 1;
+    }
+    index->keys = checkedMalloc(buckets * sizeof(int));
+    index->values = checkedMalloc(buckets * sizeof(int));
+    index->mask = buckets - 1;
+    index->size = 0;
+    for (int i = 0; i < buckets; i++) {
+        index->keys[i] = -1;
+    }
+}
+
+void pageIndexFree(PageIndex *index) {
+    free(index->keys);
+    free(index->values);
+}
+
+// Function to find the frame slot of a page, -1 if the page is not indexed
+static inline int pageIndexFind(const PageIndex *index, int page) {
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != -1) {
+        if (index->keys[bucket] == page) {
+            return index->values[bucket];
         }
+        bucket = (bucket + 1) & index->mask;
     }
-    return false;
+    return -1;
 }
 
-// Function to find the page that will not be used for the longest time
-int findOptimalPageToReplace(Page frames[], int frame_count, Page pages[], int current_page_index, int total_pages) {
-    int farthest = current_page_index;
-    int page_to_replace = -1;
+// Function to change the frame slot of a page that is already indexed
+static inline void pageIndexUpdate(PageIndex *index, int page, int value) {
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != page) {
+        bucket = (bucket + 1) & index->mask;
+    }
+    index->values[bucket] = value;
+}
 
-    for (int i = 0; i < frame_count; i++) {
-        int j;
-        for (j = current_page_index; j < total_pages; j++) {
-            if (frames[i].page_number == pages[j].page_number) {
-                // If the page is found in future references, break
-                if (j > farthest) {
-                    farthest = j;
-                    page_to_replace = i; // Update the page to replace
-                }
-                break;
+// Function to add a page that is not indexed yet, doubling the table when it gets half full
+void pageIndexInsert(PageIndex *index, int page, int value) {
+    if (2 * (index->size + 1) > index->mask + 1) {
+        PageIndex grown;
+        pageIndexInit(&grown, index->mask + 1);
+        for (int i = 0; i <= index->mask; i++) {
+            if (index->keys[i] != -1) {
+                pageIndexInsert(&grown, index->keys[i], index->values[i]);
             }
         }
-        // If the page is never found, replace it immediately
-        if (j == total_pages) {
-            return i; // The frame is eligible for replacement
+        pageIndexFree(index);
+        *index = grown;
+    }
+
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != -1) {
+        bucket = (bucket + 1) & index->mask;
+    }
+    index->keys[bucket] = page;
+    index->values[bucket] = value;
+    index->size++;
+}
+
+// Function to remove a page, shifting later entries of its probe run back so no tombstones are needed
+void pageIndexRemove(PageIndex *index, int page) {
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != page) {
+        if (index->keys[bucket] == -1) {
+            return; // The page is not indexed
+        }
+        bucket = (bucket + 1) & index->mask;
+    }
+
+    int hole = bucket;
+    for (int next = (hole + 1) & index->mask; index->keys[next] != -1; next = (next + 1) & index->mask) {
+        int home = pageIndexBucket(index, index->keys[next]);
+        // Move the entry into the hole unless its home bucket lies cyclically in (hole, next]
+        if (((next - home) & index->mask) >= ((next - hole) & index->mask)) {
+            index->keys[hole] = index->keys[next];
+            index->values[hole] = index->values[next];
+            hole = next;
         }
     }
-    return page_to_replace; // Return the frame to replace
+    index->keys[hole] = -1;
+    index->size--;
+}
+
+// Function to find, for every reference, the index of the next reference to the same page (count if there is none)
+// One backward sweep over the trace replaces the forward scan the optimal algorithm used to do on every fault
+int *buildNextUse(Page pages[], int count) {
+    int *next_use = checkedMalloc(count * sizeof(int));
+    PageIndex upcoming; // Page number -> index of its earliest reference after the sweep position
+    pageIndexInit(&upcoming, 1024);
+
+    for (int i = count - 1; i >= 0; i--) {
+        int next = pageIndexFind(&upcoming, pages[i].page_number);
+        if (next == -1) {
+            next_use[i] = count; // Never referenced again
+            pageIndexInsert(&upcoming, pages[i].page_number, i);
+        } else {
+            next_use[i] = next;
+            pageIndexUpdate(&upcoming, pages[i].page_number, i);
+        }
+    }
+
+    pageIndexFree(&upcoming);
+    return next_use;
 }
 
+// Heap order for the optimal algorithm: the frame whose page is used farthest in the future comes first,
+// ties (pages never used again and empty frames) go to the lowest frame index
+static inline bool evictsBefore(const int *next_use_of, int a, int b) {
+    return next_use_of[a] > next_use_of[b] || (next_use_of[a] == next_use_of[b] && a < b);
+}
+
+static void heapSiftUp(int *heap, int *heap_pos, const int *next_use_of, int pos) {
+    int frame = heap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!evictsBefore(next_use_of, frame, heap[parent])) {
+            break;
+        }
+        heap[pos] = heap[parent];
+        heap_pos[heap[pos]] = pos;
+        pos = parent;
+    }
+    heap[pos] = frame;
+    heap_pos[frame] = pos;
+}
+
+static void heapSiftDown(int *heap, int *heap_pos, const int *next_use_of, int size, int pos) {
+    int frame = heap[pos];
+    while (2 * pos + 1 < size) {
+        int child = 2 * pos + 1;
+        if (child + 1 < size && evictsBefore(next_use_of, heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!evictsBefore(next_use_of, heap[child], frame)) {
+            break;
+        }
+        heap[pos] = heap[child];
+        heap_pos[heap[pos]] = pos;
+        pos = child;
+    }
+    heap[pos] = frame;
+    heap_pos[frame] = pos;
+}
 // Optimal Page Replacement Algorithm
-void Optimal(Page pages[], int count, int frame_count) {
-    Page frames[frame_count];       // Array of frames with size of frame_count 
+// Frames sit in a max-heap keyed on the next use of their page, so the victim is always the heap root and
+// each reference costs O(log frame_count). next_use comes from buildNextUse.
+void Optimal(Page pages[], int count, int frame_count, const int *next_use) {
+    int *dirty = checkedMalloc(frame_count * sizeof(int)); // Dirty bit of the page in each frame
+    int *next_use_of = checkedMalloc(frame_count * sizeof(int)); // Next reference to the page in each frame, count if none
+    int *heap = checkedMalloc(frame_count * sizeof(int)); // Frames ordered by evictsBefore
+    int *heap_pos = checkedMalloc(frame_count * sizeof(int)); // Position of each frame in the heap
+    int *owner = checkedMalloc(count * sizeof(int)); // owner[j] is the frame holding the page referenced at j, -1 if not resident
     int page_faults = 0;  // Count of page faults
     int writeBacks = 0;
     
-    // Initialize frames
+    // Initialize frames, every empty frame is a candidate that is never used
     for (int i = 0; i < frame_count; i++) {
-        frames[i].page_number = -1; // fill the frame with empty pages
-        frames[i].dirty = 0; // fill the frame with empty pages
+        dirty[i] = 0;
+        next_use_of[i] = count;
+        heap[i] = i;
+        heap_pos[i] = i;
+    }
+    for (int j = 0; j < count; j++) {
+        owner[j] = -1;
     }
 
     for (int i = 0; i < count; i++) {
-        Page current_page = pages[i];
+        int frame = owner[i];
 
         // Check if the current page is already in the frames
-        if (!isPagePresent(frames, frame_count, current_page)) {
+        if (frame == -1) {
             // Page fault occurs
             page_faults++;
 
-            // Determine which page to replace using optimal algorithm
-            int page_to_replace = findOptimalPageToReplace(frames, frame_count, pages, i, count);
+            // The root of the heap is the page that will not be used for the longest time
+            frame = heap[0];
             
             // Check if there is a need to write back a dirty page
-            if (page_to_replace != -1 && frames[page_to_replace].dirty == 1) {
+            if (dirty[frame] == 1) {
                 writeBacks++;
             }
+            if (next_use_of[frame] < count) {
+                owner[next_use_of[frame]] = -1;
+            }
 
-            // Replace the page in the frame
-            frames[page_to_replace] = current_page;
+            // Replace the page in the frame, its next use can only be sooner than the evicted one's
+            dirty[frame] = pages[i].dirty;
+            next_use_of[frame] = next_use[i];
+            heapSiftDown(heap, heap_pos, next_use_of, frame_count, 0);
         }  else {
 
             // if the page is present, but the dirty bit is different
-            for (int j = 0; j < frame_count; j++) {
-                if(frames[j].page_number == current_page.page_number){
-                    if (frames[j].dirty == 0 && current_page.dirty ==1)    
-                        frames[j].dirty = 1;
-                        //writeBacks++;
-                }
-
-            
+            if (dirty[frame] == 0 && pages[i].dirty == 1) {
+                dirty[frame] = 1;
             }
+
+            // The page's next use moves further into the future
+            next_use_of[frame] = next_use[i];
+            heapSiftUp(heap, heap_pos, next_use_of, heap_pos[frame]);
         }
 
+        if (next_use[i] < count) {
+            owner[next_use[i]] = frame;
+        }
     }
 
     // Print results for this iteration
@@ -97,9 +252,133 @@ void Optimal(Page pages[], int count, int frame_count) {
     
     // print the last line
     printf("+--------+--------------+-------------+\n");
+
+    free(dirty);
+    free(next_use_of);
+    free(heap);
+    free(heap_pos);
+    free(owner);
+}
+
+// Entry of the Belady priority stack used by OptimalStack
+typedef struct {
+    int next_use;    // Next reference to the page, count if it is never used again
+    int last_use;    // Most recent reference to the page, orders pages that are never used again
+    int dirty_from;  // Smallest pool whose copy of the page is dirty, INT_MAX if none
+} OptStackEntry;
+
+// Priority of the optimal stack: the page used sooner stays higher, among pages never used again the more recent one
+static inline bool optStackOutranks(const OptStackEntry *a, const OptStackEntry *b) {
+    return a->next_use < b->next_use || (a->next_use == b->next_use && a->last_use > b->last_use);
+}
+
+// Function to add the pools in [low, min(high, max_frames)] to a write-back difference array
+static inline void addWriteBackRange(long long *writeBacks, int max_frames, int low, int high) {
+    if (high > max_frames) {
+        high = max_frames;
+    }
+    if (low <= high) {
+        writeBacks[low]++;
+        writeBacks[high + 1]--;
+    }
+}
+
+// Optimal for every frame count 1..max_frames in a single pass over the trace
+// OPT is a stack algorithm: the top c entries of the priority stack are exactly the pages an optimal pool of
+// c frames holds. On each reference the page moves to the top and the displaced entries sift down, each
+// position keeping the higher priority of the carried entry and its current one. Only the top max_frames
+// entries are kept, which makes a reference cost O(max_frames) at worst.
+// Fault counts match Optimal(). Write-backs are exact for this stack, but when several resident pages are
+// never used again Optimal() evicts by frame position, so its write-back counts can differ slightly.
+void OptimalStack(Page pages[], int count, int max_frames, const int *next_use) {
+    OptStackEntry *stack = checkedMalloc(max_frames * sizeof(OptStackEntry)); // stack[0] is the top
+    long long *faults = calloc(max_frames + 2, sizeof(long long)); // Histogram of stack distances, then faults per pool
+    long long *writeBacks = calloc(max_frames + 2, sizeof(long long)); // Difference array, then write backs per pool
+    int depth = 0; // Entries currently on the stack
+
+    if (faults == NULL || writeBacks == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < count; i++) {
+        // Every entry's priority is its next use, so the current page is the entry whose next use is now
+        OptStackEntry carry = depth > 0 ? stack[0] : (OptStackEntry){0, 0, 0};
+        OptStackEntry current = {next_use[i], i, INT_MAX};
+        int distance = 0; // Stack distance of the reference, 0 if it misses every pool
+
+        if (depth > 0 && stack[0].next_use == i) {
+            distance = 1;
+            current.dirty_from = stack[0].dirty_from;
+        } else {
+            int pos;
+            for (pos = 1; pos < depth; pos++) {
+                if (stack[pos].next_use == i) {
+                    break;
+                }
+                if (optStackOutranks(&carry, &stack[pos])) {
+                    OptStackEntry lower = carry;
+                    carry = stack[pos];
+                    stack[pos] = lower;
+                }
+            }
+
+            if (pos < depth) {
+                distance = pos + 1;
+                current.dirty_from = stack[pos].dirty_from;
+                stack[pos] = carry;
+            } else if (depth < max_frames) {
+                if (depth > 0) {
+                    stack[depth] = carry;
+                }
+                depth++;
+            } else {
+                // The carried entry drops below the deepest pool, which evicts it from every pool
+                addWriteBackRange(writeBacks, max_frames, carry.dirty_from, max_frames);
+            }
+        }
+
+        if (distance == 0) {
+            faults[max_frames + 1]++;
+        } else {
+            faults[distance]++;
+            // Pools in [dirty_from, distance - 1] evicted a dirty copy of this page since its last reference
+            addWriteBackRange(writeBacks, max_frames, current.dirty_from, distance - 1);
+            if (current.dirty_from < distance) {
+                current.dirty_from = distance;
+            }
+        }
+        if (pages[i].dirty == 1) {
+            current.dirty_from = 1;
+        }
+        stack[0] = current;
+    }
+
+    // Pages still on the stack were evicted only from pools smaller than their final depth
+    for (int pos = 0; pos < depth; pos++) {
+        addWriteBackRange(writeBacks, max_frames, stack[pos].dirty_from, pos);
+    }
+
+    // A pool of c frames faults on every reference with distance greater than c
+    long long missing = faults[max_frames + 1];
+    long long running = 0;
+    for (int c = max_frames; c >= 1; c--) {
+        long long hits_at_c = faults[c];
+        faults[c] = missing;
+        missing += hits_at_c;
+    }
+    for (int c = 1; c <= max_frames; c++) {
+        running += writeBacks[c];
+        printf("| %-6d | %-12lld | %-11lld |\n", c, faults[c], running);
+        printf("+--------+--------------+-------------+\n");
+    }
+
+    free(stack);
+    free(faults);
+    free(writeBacks);
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     FILE *file;
     char line[256]; 
     Page *listOfPages = NULL; // Pointer for dynamic allocation
@@ -153,10 +432,17 @@ int main() {
     printf("| Frames | Page Faults  | Write backs |\n");
     printf("+--------+--------------+-------------+\n");
     
-    // Call Optimal from frame size 1-100
-    for (int i = 1; i < 101; i++) {
-        Optimal(listOfPages, index, i);
+    // Call Optimal from frame size 1-100, the next-use index is shared by every frame size
+    int *next_use = buildNextUse(listOfPages, index);
+    if (argc > 1 && strcmp(argv[1], "stack") == 0) {
+        // One pass over the trace for every frame size
+        OptimalStack(listOfPages, index, 100, next_use);
+    } else {
+        for (int i = 1; i < 101; i++) {
+            Optimal(listOfPages, index, i, next_use);
+        }
     }
+    free(next_use);
 
     // Free the dynamically allocated memory
     free(listOfPages);
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// Throughput benchmark for pageReplacement
+// Generates a trace of each size with traceGenerator, then runs every policy on it as a separate process so
+// the time and peak memory of each one are measured on their own, the same way a user would run it.
+//   benchmark [--sizes 1e5,1e6,1e7] [--universe U] [--pattern P] [--seed S] [--policies FIFO,LRU,OPT,SC]
+//             [--runs R] [--binary] [--simulator PATH] [--generator PATH] [-- simulator options]
+// Each run covers the whole frame sweep of the policy, so ns/ref is the cost of one reference across all
+// frame counts. The fastest of the R runs is reported along with the highest peak RSS.
+
+#define MAX_SIZES 32
+#define MAX_POLICIES 16
+#define MAX_ARGUMENTS 64
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// Run program with stdin and stdout redirected, returns false if it could not run or did not exit with 0
+// The elapsed wall time and the peak resident set of the child are left in seconds and maxRssKiB
+static bool runProcess(char *const arguments[], int inputFd, int outputFd, double *seconds, long *maxRssKiB) {
+    double start = now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Error: fork failed");
+        return false;
+    }
+    if (pid == 0) {
+        if ((inputFd >= 0 && dup2(inputFd, STDIN_FILENO) < 0) || dup2(outputFd, STDOUT_FILENO) < 0) {
+            _exit(127);
+        }
+        execvp(arguments[0], arguments);
+        fprintf(stderr, "Error: Cannot run %s: %s\n", arguments[0], strerror(errno));
+        _exit(127);
+    }
+
+    int status;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) {
+            perror("Error: wait4 failed");
+            return false;
+        }
+    }
+    *seconds = now() - start;
+    *maxRssKiB = usage.ru_maxrss; // Reported in KiB on Linux
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Split a comma separated list in place, returns the number of items or -1 if there are too many
+static int splitList(char *list, char *items[], int capacity) {
+    int count = 0;
+    for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+        if (count == capacity) {
+            return -1;
+        }
+        items[count++] = item;
+    }
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    char defaultSizes[] = "100000,1000000,10000000";
+    char defaultPolicies[] = "FIFO,LRU,OPT,SC";
+    char *sizeList = defaultSizes;
+    char *policyList = defaultPolicies;
+    const char *universe = "1000";
+    const char *pattern = "zipf";
+    const char *seed = "1";
+    const char *simulator = "./pageReplacement";
+    const char *generator = "./traceGenerator";
+    int runs = 3;
+    bool binary = false;
+    int extraStart = argc; // Options after -- go to every simulator run
+
+    for (int arg = 1; arg < argc; arg++) {
+        bool hasValue = arg + 1 < argc;
+        if (strcmp(argv[arg], "--") == 0) {
+            extraStart = arg + 1;
+            break;
+        } else if (strcmp(argv[arg], "--sizes") == 0 && hasValue) {
+            sizeList = argv[++arg];
+        } else if (strcmp(argv[arg], "--policies") == 0 && hasValue) {
+            policyList = argv[++arg];
+        } else if (strcmp(argv[arg], "--universe") == 0 && hasValue) {
+            universe = argv[++arg];
+        } else if (strcmp(argv[arg], "--pattern") == 0 && hasValue) {
+            pattern = argv[++arg];
+        } else if (strcmp(argv[arg], "--seed") == 0 && hasValue) {
+            seed = argv[++arg];
+        } else if (strcmp(argv[arg], "--simulator") == 0 && hasValue) {
+            simulator = argv[++arg];
+        } else if (strcmp(argv[arg], "--generator") == 0 && hasValue) {
+            generator = argv[++arg];
+        } else if (strcmp(argv[arg], "--runs") == 0 && hasValue) {
+            runs = atoi(argv[++arg]);
+            if (runs < 1) {
+                fprintf(stderr, "Error: --runs expects a positive count.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--binary") == 0) {
+            binary = true;
+        } else {
+            fprintf(stderr, "Error: Unknown option %s (benchmark [--sizes N,...] [--universe U] [--pattern P] [--seed S] [--policies FIFO,LRU,OPT,SC] [--runs R] [--binary] [--simulator PATH] [--generator PATH] [-- simulator options]).\n", argv[arg]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    char *sizes[MAX_SIZES];
+    char *policies[MAX_POLICIES];
+    int sizeCount = splitList(sizeList, sizes, MAX_SIZES);
+    int policyCount = splitList(policyList, policies, MAX_POLICIES);
+    if (sizeCount <= 0 || policyCount <= 0 || 2 + argc - extraStart >= MAX_ARGUMENTS) {
+        fprintf(stderr, "Error: Too many or too few sizes, policies or simulator options.\n");
+        return EXIT_FAILURE;
+    }
+
+    char tracePath[] = "/tmp/benchmarkTraceXXXXXX";
+    int traceFd = mkstemp(tracePath);
+    int nullFd = open("/dev/null", O_WRONLY);
+    if (traceFd < 0 || nullFd < 0) {
+        perror("Error: Cannot create the trace file");
+        return EXIT_FAILURE;
+    }
+    unlink(tracePath); // Removed on exit, the descriptor keeps it alive
+
+    int status = EXIT_SUCCESS;
+    printf("Pattern %s, universe %s, seed %s, best of %d runs\n", pattern, universe, seed, runs);
+    printf("+--------+--------------+-----------+--------------+-----------+--------------+\n");
+    printf("| Policy | References   | Seconds   | Refs/sec     | ns/ref    | Peak RSS KiB |\n");
+    printf("+--------+--------------+-----------+--------------+-----------+--------------+\n");
+
+    for (int s = 0; s < sizeCount && status == EXIT_SUCCESS; s++) {
+        char *generatorArguments[] = {(char *)generator, "--refs", sizes[s], "--universe", (char *)universe,
+                                      "--pattern", (char *)pattern, "--seed", (char *)seed,
+                                      binary ? "--binary" : NULL, NULL};
+        double seconds;
+        long maxRss;
+        if (ftruncate(traceFd, 0) != 0 || lseek(traceFd, 0, SEEK_SET) != 0 ||
+            !runProcess(generatorArguments, -1, traceFd, &seconds, &maxRss)) {
+            fprintf(stderr, "Error: Cannot generate a trace of %s references.\n", sizes[s]);
+            status = EXIT_FAILURE;
+            break;
+        }
+        double references = strtod(sizes[s], NULL);
+
+        for (int p = 0; p < policyCount; p++) {
+            char *simulatorArguments[MAX_ARGUMENTS];
+            int count = 0;
+            simulatorArguments[count++] = (char *)simulator;
+            simulatorArguments[count++] = policies[p];
+            for (int arg = extraStart; arg < argc; arg++) {
+                simulatorArguments[count++] = argv[arg];
+            }
+            simulatorArguments[count] = NULL;
+
+            double best = 0;
+            long peak = 0;
+            for (int run = 0; run < runs; run++) {
+                if (lseek(traceFd, 0, SEEK_SET) != 0 ||
+                    !runProcess(simulatorArguments, traceFd, nullFd, &seconds, &maxRss)) {
+                    fprintf(stderr, "Error: %s %s failed on %s references.\n", simulator, policies[p], sizes[s]);
+                    status = EXIT_FAILURE;
+                    break;
+                }
+                if (run == 0 || seconds < best) {
+                    best = seconds;
+                }
+                if (maxRss > peak) {
+                    peak = maxRss;
+                }
+            }
+            if (status != EXIT_SUCCESS) {
+                break;
+            }
+            printf("| %-6s | %-12.0f | %-9.3f | %-12.0f | %-9.1f | %-12ld |\n", policies[p], references, best,
+                   references / best, best * 1e9 / references, peak);
+            fflush(stdout);
+        }
+        printf("+--------+--------------+-----------+--------------+-----------+--------------+\n");
+    }
+
+    close(traceFd);
+    close(nullFd);
+    return status;
+}
@@ -2,7 +2,22 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h> // Build with -pthread
+#include <stdatomic.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #define MAX_PAGES 500
+#define SWEEP_FRAMES 100 // Frame counts 1..SWEEP_FRAMES are simulated
 
 // Structure to hold page information
 typedef struct {
@@ -10,267 +25,3858 @@ typedef struct {
     int dirty; // 0 or 1
 } Page;
 
-// Function to find if the page is present in the frame
-bool isPagePresent(Page frames[], int frame_count, Page page) {
+// Optional instrumentation. Build with -DPR_STATS and pass --stats FILE to get the counters of every
+// simulation as JSON next to the table. Without PR_STATS the STAT_ macros expand to nothing, so the
+// engines compile to exactly the code they had before.
+#ifdef PR_STATS
+// Counters of one simulation, hits, misses and dirty evictions follow from these and SimResult
+typedef struct {
+    long long references;
+    long long evictions;        // Misses that displaced a resident page, the rest filled an empty frame
+    long long lookups;          // Page index lookups
+    long long probes;           // Buckets or slots examined by those lookups
+    long long victim_search;    // Frames examined to choose victims
+    unsigned long long cycles;  // Time stamp counter ticks spent in the engine, 0 where there is none
+} RunStats;
+
+// Lookups and probes are counted per thread inside the page index and handed to the engine that ran them
+static _Thread_local long long statLookups = 0;
+static _Thread_local long long statProbes = 0;
+
+static inline unsigned long long statCycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double statNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Wall time of each phase of the run
+static struct {
+    double load;
+    double preprocess;
+    double simulate;
+} statPhases;
+
+#define STAT_ADD(stats, field, amount) ((stats).field += (amount))
+#define STAT_LOOKUP() (statLookups++)
+#define STAT_PROBE(amount) (statProbes += (amount))
+#define STAT_RUN_BEGIN() \
+    long long statLookupsStart = statLookups, statProbesStart = statProbes; \
+    unsigned long long statCyclesStart = statCycles()
+#define STAT_RUN_END(stats, count) \
+    ((stats).cycles += statCycles() - statCyclesStart, (stats).lookups += statLookups - statLookupsStart, \
+     (stats).probes += statProbes - statProbesStart, (stats).references += (count))
+#define STAT_CLOCK(name) double name = statNow()
+#define STAT_PHASE(phase, since) (statPhases.phase += statNow() - (since))
+#define STAT_ATTACH(result, run_stats) ((result).stats = (run_stats))
+#else
+#define STAT_ADD(stats, field, amount) ((void)0)
+#define STAT_LOOKUP() ((void)0)
+#define STAT_PROBE(amount) ((void)0)
+#define STAT_RUN_BEGIN() ((void)0)
+#define STAT_RUN_END(stats, count) ((void)0)
+#define STAT_CLOCK(name) ((void)0)
+#define STAT_PHASE(phase, since) ((void)0)
+#define STAT_ATTACH(result, run_stats) ((void)0)
+#endif
+
+// Fault and write-back counts of one simulation
+typedef struct {
+    int frame_count;
+    int page_faults;
+    int writeBacks;
+#ifdef PR_STATS
+    RunStats stats;
+#endif
+} SimResult;
+
+// Allocate memory or abort the program with an error message
+void *checkedMalloc(size_t size) {
+    void *memory = malloc(size);
+    if (memory == NULL && size != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// Index from page number to frame slot
+// By default an open-addressing hash table (linear probing). When the trace has been remapped to dense page
+// ids (see remapTrace) it is a flat page -> frame array guarded by a residency bitset instead, so a lookup is
+// one bit test, plus one array load on a hit. The compact mode stores the frame slots in 16 bits, which
+// halves the per-page state so the indexes of several pools fit in the L2 cache together.
+typedef struct {
+    int *keys;    // page number stored in each bucket, -1 marks an empty bucket
+    int *values;  // frame slot of the page stored in each bucket
+    int mask;     // bucket count - 1, the bucket count is a power of two
+    int size;     // number of pages stored
+    unsigned long long *resident; // Dense mode: one bit per page id, NULL for a hash index
+    int *frameOf;                 // Dense mode: page id -> frame slot, valid while the page's bit is set
+    unsigned short *slotOf;       // Compact mode: frameOf for pools of at most COMPACT_POOL_SLOTS slots
+    int *slots;                   // Scan mode: page held by each frame (-1 if empty), padded and 32-byte aligned
+    int slotCount;                // Scan mode: number of frames
+} PageIndex;
+
+// Pools of at most this many slots can use the compact index
+#define COMPACT_POOL_SLOTS 65535
+
+// Pools of at most this many frames are indexed by scanning their page numbers with SIMD compares
+#define SCAN_POOL_FRAMES 64
+
+// Vector width for the scan kernel, detected once at startup by detectSimd
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2
+} SimdLevel;
+
+static SimdLevel simdLevel = SIMD_SCALAR;
+
+void detectSimd(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        simdLevel = SIMD_AVX2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        simdLevel = SIMD_SSE2;
+    }
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Compare 8 frames per step and use the movemask of the matches to find the frame
+__attribute__((target("avx2")))
+static int findSlotAvx2(const int *slots, int padded_count, int page) {
+    __m256i needle = _mm256_set1_epi32(page);
+    for (int i = 0; i < padded_count; i += 8) {
+        __m256i block = _mm256_load_si256((const __m256i *)(slots + i));
+        unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return -1;
+}
+
+__attribute__((target("sse2")))
+static int findSlotSse2(const int *slots, int padded_count, int page) {
+    __m128i needle = _mm_set1_epi32(page);
+    for (int i = 0; i < padded_count; i += 4) {
+        __m128i block = _mm_load_si128((const __m128i *)(slots + i));
+        unsigned int mask = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return -1;
+}
+#endif
+
+// Function to find the frame holding page in a small pool, dispatching on the detected vector width
+static inline int findSlot(const int *slots, int count, int page) {
+    int padded_count = (count + 7) & ~7;
+    int frame = -1;
+#if defined(__x86_64__) || defined(__i386__)
+    if (simdLevel == SIMD_AVX2) {
+        frame = findSlotAvx2(slots, padded_count, page);
+    } else if (simdLevel == SIMD_SSE2) {
+        frame = findSlotSse2(slots, padded_count, page);
+    } else
+#endif
+    {
+        for (int i = 0; i < count; i++) {
+            if (slots[i] == page) {
+                frame = i;
+                break;
+            }
+        }
+    }
+    return frame < count ? frame : -1; // The padding never holds a real page
+}
+
+// Function to map a page number to its home bucket
+static inline int pageIndexBucket(const PageIndex *index, int page) {
+    unsigned int hash = (unsigned int)page * 2654435769u;
+    return (int)((hash ^ (hash >> 15)) & (unsigned int)index->mask);
+}
+
+// Function to allocate buckets for at least capacity pages at 50% load
+void pageIndexInit(PageIndex *index, int capacity) {
+    int buckets = 16;
+    while (buckets < 2 * capacity) {
+        buckets <<= 1;
+    }
+    index->keys = checkedMalloc(buckets * sizeof(int));
+    index->values = checkedMalloc(buckets * sizeof(int));
+    index->mask = buckets - 1;
+    index->size = 0;
+    index->resident = NULL;
+    index->frameOf = NULL;
+    index->slotOf = NULL;
+    index->slots = NULL;
+    for (int i = 0; i < buckets; i++) {
+        index->keys[i] = -1;
+    }
+}
+
+// Function to allocate a flat index for dense page ids 0..universe-1
+void pageIndexInitDense(PageIndex *index, int universe) {
+    index->keys = NULL;
+    index->values = NULL;
+    index->mask = 0;
+    index->size = 0;
+    index->resident = calloc((universe + 63) / 64, sizeof(unsigned long long));
+    index->frameOf = checkedMalloc(universe * sizeof(int));
+    index->slotOf = NULL;
+    index->slots = NULL;
+    if (index->resident == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to allocate a scanned index for a pool of frame_count frames, the frame slot is the array position
+void pageIndexInitScan(PageIndex *index, int frame_count) {
+    int padded_count = (frame_count + 7) & ~7;
+    index->keys = NULL;
+    index->values = NULL;
+    index->mask = 0;
+    index->size = 0;
+    index->resident = NULL;
+    index->frameOf = NULL;
+    index->slotOf = NULL;
+    index->slots = aligned_alloc(32, padded_count * sizeof(int));
+    index->slotCount = frame_count;
+    if (index->slots == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < padded_count; i++) {
+        index->slots[i] = -1;
+    }
+}
+
+// Function to allocate a compact index for dense page ids 0..universe-1
+void pageIndexInitCompact(PageIndex *index, int universe) {
+    index->keys = NULL;
+    index->values = NULL;
+    index->mask = 0;
+    index->size = 0;
+    index->resident = calloc((universe + 63) / 64, sizeof(unsigned long long));
+    index->frameOf = NULL;
+    index->slotOf = checkedMalloc(universe * sizeof(unsigned short));
+    index->slots = NULL;
+    if (index->resident == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to set up the index of a pool of frame_count frames: flat if the trace uses dense ids (universe > 0),
+// a SIMD scan for small pools, otherwise a hash table. compact asks for the 16-bit flat index when it fits.
+void pageIndexInitPool(PageIndex *index, int frame_count, int universe, bool compact) {
+    if (universe > 0 && compact && frame_count <= COMPACT_POOL_SLOTS) {
+        pageIndexInitCompact(index, universe);
+    } else if (universe > 0) {
+        pageIndexInitDense(index, universe);
+    } else if (frame_count <= SCAN_POOL_FRAMES) {
+        pageIndexInitScan(index, frame_count);
+    } else {
+        pageIndexInit(index, frame_count);
+    }
+}
+
+void pageIndexFree(PageIndex *index) {
+    free(index->keys);
+    free(index->values);
+    free(index->resident);
+    free(index->frameOf);
+    free(index->slotOf);
+    free(index->slots);
+}
+
+// Function to find the frame slot of a page, -1 if the page is not indexed
+static inline int pageIndexFind(const PageIndex *index, int page) {
+    STAT_LOOKUP();
+    if (index->resident != NULL) {
+        STAT_PROBE(1);
+        if (!(index->resident[page >> 6] >> (page & 63) & 1)) {
+            return -1;
+        }
+        return index->frameOf != NULL ? index->frameOf[page] : index->slotOf[page];
+    }
+    if (index->slots != NULL) {
+        int frame = findSlot(index->slots, index->slotCount, page);
+        STAT_PROBE(frame == -1 ? index->slotCount : frame + 1);
+        return frame;
+    }
+
+    int bucket = pageIndexBucket(index, page);
+    STAT_PROBE(1);
+    while (index->keys[bucket] != -1) {
+        if (index->keys[bucket] == page) {
+            return index->values[bucket];
+        }
+        bucket = (bucket + 1) & index->mask;
+        STAT_PROBE(1);
+    }
+    return -1;
+}
+
+// Function to change the frame slot of a page that is already indexed
+static inline void pageIndexUpdate(PageIndex *index, int page, int value) {
+    if (index->resident != NULL) {
+        if (index->frameOf != NULL) {
+            index->frameOf[page] = value;
+        } else {
+            index->slotOf[page] = (unsigned short)value;
+        }
+        return;
+    }
+    if (index->slots != NULL) {
+        index->slots[findSlot(index->slots, index->slotCount, page)] = -1;
+        index->slots[value] = page;
+        return;
+    }
+
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != page) {
+        bucket = (bucket + 1) & index->mask;
+    }
+    index->values[bucket] = value;
+}
+
+// Function to add a page that is not indexed yet, doubling the table when it gets half full
+void pageIndexInsert(PageIndex *index, int page, int value) {
+    if (index->resident != NULL) {
+        index->resident[page >> 6] |= 1ull << (page & 63);
+        if (index->frameOf != NULL) {
+            index->frameOf[page] = value;
+        } else {
+            index->slotOf[page] = (unsigned short)value;
+        }
+        index->size++;
+        return;
+    }
+    if (index->slots != NULL) {
+        index->slots[value] = page;
+        index->size++;
+        return;
+    }
+
+    if (2 * (index->size + 1) > index->mask + 1) {
+        PageIndex grown;
+        pageIndexInit(&grown, index->mask + 1);
+        for (int i = 0; i <= index->mask; i++) {
+            if (index->keys[i] != -1) {
+                pageIndexInsert(&grown, index->keys[i], index->values[i]);
+            }
+        }
+        pageIndexFree(index);
+        *index = grown;
+    }
+
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != -1) {
+        bucket = (bucket + 1) & index->mask;
+    }
+    index->keys[bucket] = page;
+    index->values[bucket] = value;
+    index->size++;
+}
+
+// Function to remove a page, shifting later entries of its probe run back so no tombstones are needed
+void pageIndexRemove(PageIndex *index, int page) {
+    if (index->resident != NULL) {
+        index->resident[page >> 6] &= ~(1ull << (page & 63));
+        index->size--;
+        return;
+    }
+    if (index->slots != NULL) {
+        int frame = findSlot(index->slots, index->slotCount, page);
+        if (frame != -1) {
+            index->slots[frame] = -1;
+            index->size--;
+        }
+        return;
+    }
+
+    int bucket = pageIndexBucket(index, page);
+    while (index->keys[bucket] != page) {
+        if (index->keys[bucket] == -1) {
+            return; // The page is not indexed
+        }
+        bucket = (bucket + 1) & index->mask;
+    }
+
+    int hole = bucket;
+    for (int next = (hole + 1) & index->mask; index->keys[next] != -1; next = (next + 1) & index->mask) {
+        int home = pageIndexBucket(index, index->keys[next]);
+        // Move the entry into the hole unless its home bucket lies cyclically in (hole, next]
+        if (((next - home) & index->mask) >= ((next - hole) & index->mask)) {
+            index->keys[hole] = index->keys[next];
+            index->values[hole] = index->values[next];
+            hole = next;
+        }
+    }
+    index->keys[hole] = -1;
+    index->size--;
+}
+
+// Intrusive doubly linked list threaded through per-frame prev/next arrays
+typedef struct {
+    int head;  // most recently inserted frame, -1 when the list is empty
+    int tail;  // least recently inserted frame, -1 when the list is empty
+    int size;
+} FrameList;
+
+void frameListInit(FrameList *list) {
+    list->head = -1;
+    list->tail = -1;
+    list->size = 0;
+}
+
+// Function to insert a frame at the head of the list
+static inline void frameListPushFront(FrameList *list, int *prev, int *next, int frame) {
+    prev[frame] = -1;
+    next[frame] = list->head;
+    if (list->head != -1) {
+        prev[list->head] = frame;
+    } else {
+        list->tail = frame;
+    }
+    list->head = frame;
+    list->size++;
+}
+
+// Function to remove a frame from anywhere in the list
+static inline void frameListUnlink(FrameList *list, int *prev, int *next, int frame) {
+    if (prev[frame] != -1) {
+        next[prev[frame]] = next[frame];
+    } else {
+        list->head = next[frame];
+    }
+    if (next[frame] != -1) {
+        prev[next[frame]] = prev[frame];
+    } else {
+        list->tail = prev[frame];
+    }
+    list->size--;
+}
+
+// Mattson stack distances. A Fenwick tree over access timestamps holds a 1 at every page's most recent
+// access, so the number of distinct pages touched since a page was last used is a single prefix query.
+// Timestamps are compacted whenever they run out, which keeps memory proportional to the distinct pages.
+typedef struct {
+    PageIndex slots;   // page number -> dense slot
+    int *lastTime;     // slot -> timestamp of the page's most recent access
+    int *pageAt;       // timestamp -> slot accessed at that time, -1 once superseded
+    int *tree;         // Fenwick tree over timestamps 1..capacity
+    int capacity;      // timestamps available before the next compaction
+    int now;           // most recent timestamp handed out
+    int distinct;      // distinct pages tracked, pages that were removed no longer count
+    int slotsUsed;     // slots handed out so far, equal to distinct unless pages were removed
+    int freeSlot;      // most recently released slot, -1 if none, older ones chained through lastTime
+    int slotCapacity;
+} StackDistance;
+
+void stackDistanceInit(StackDistance *sd) {
+    pageIndexInit(&sd->slots, 1024);
+    sd->slotCapacity = 1024;
+    sd->lastTime = checkedMalloc(sd->slotCapacity * sizeof(int));
+    sd->capacity = 1024;
+    sd->pageAt = checkedMalloc((sd->capacity + 1) * sizeof(int));
+    sd->tree = calloc(sd->capacity + 1, sizeof(int));
+    if (sd->tree == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    sd->now = 0;
+    sd->distinct = 0;
+    sd->slotsUsed = 0;
+    sd->freeSlot = -1;
+}
+
+void stackDistanceFree(StackDistance *sd) {
+    pageIndexFree(&sd->slots);
+    free(sd->lastTime);
+    free(sd->pageAt);
+    free(sd->tree);
+}
+
+static inline void fenwickAdd(int *tree, int size, int position, int delta) {
+    for (; position <= size; position += position & -position) {
+        tree[position] += delta;
+    }
+}
+
+static inline int fenwickPrefix(const int *tree, int position) {
+    int sum = 0;
+    for (; position > 0; position -= position & -position) {
+        sum += tree[position];
+    }
+    return sum;
+}
+
+// Function to renumber the live timestamps 1..distinct, growing the timestamp space if it is over half full
+void stackDistanceCompact(StackDistance *sd) {
+    int old_now = sd->now;
+    if (2 * sd->distinct > sd->capacity) {
+        sd->capacity *= 2;
+        sd->pageAt = realloc(sd->pageAt, (sd->capacity + 1) * sizeof(int));
+        sd->tree = realloc(sd->tree, (sd->capacity + 1) * sizeof(int));
+        if (sd->pageAt == NULL || sd->tree == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int time = 0;
+    for (int t = 1; t <= old_now; t++) {
+        if (sd->pageAt[t] != -1) {
+            time++;
+            sd->pageAt[time] = sd->pageAt[t];
+            sd->lastTime[sd->pageAt[time]] = time;
+        }
+    }
+    for (int t = time + 1; t <= sd->capacity; t++) {
+        sd->pageAt[t] = -1;
+    }
+
+    // Linear-time Fenwick build with ones at timestamps 1..time
+    for (int t = 1; t <= sd->capacity; t++) {
+        sd->tree[t] = t <= time ? 1 : 0;
+    }
+    for (int t = 1; t <= sd->capacity; t++) {
+        int parent = t + (t & -t);
+        if (parent <= sd->capacity) {
+            sd->tree[parent] += sd->tree[t];
+        }
+    }
+    sd->now = time;
+}
+
+// Function to record an access and return its stack distance (1 = most recently used page), 0 on first access
+int stackDistanceAccess(StackDistance *sd, int page, int *slot) {
+    if (sd->now == sd->capacity) {
+        stackDistanceCompact(sd);
+    }
+
+    int distance = 0;
+    int s = pageIndexFind(&sd->slots, page);
+    if (s == -1 && sd->freeSlot != -1) {
+        s = sd->freeSlot;
+        sd->freeSlot = sd->lastTime[s];
+        sd->distinct++;
+        pageIndexInsert(&sd->slots, page, s);
+    } else if (s == -1) {
+        s = sd->slotsUsed++;
+        sd->distinct++;
+        if (s == sd->slotCapacity) {
+            sd->slotCapacity *= 2;
+            sd->lastTime = realloc(sd->lastTime, sd->slotCapacity * sizeof(int));
+            if (sd->lastTime == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        pageIndexInsert(&sd->slots, page, s);
+    } else {
+        int last = sd->lastTime[s];
+        distance = 1 + sd->distinct - fenwickPrefix(sd->tree, last);
+        fenwickAdd(sd->tree, sd->capacity, last, -1);
+        sd->pageAt[last] = -1;
+    }
+
+    sd->now++;
+    fenwickAdd(sd->tree, sd->capacity, sd->now, 1);
+    sd->pageAt[sd->now] = s;
+    sd->lastTime[s] = sd->now;
+    *slot = s;
+    return distance;
+}
+
+// Function to stop tracking a page, as if it had never been accessed
+void stackDistanceRemove(StackDistance *sd, int page) {
+    int s = pageIndexFind(&sd->slots, page);
+    if (s == -1) {
+        return;
+    }
+    int last = sd->lastTime[s];
+    fenwickAdd(sd->tree, sd->capacity, last, -1);
+    sd->pageAt[last] = -1;
+    pageIndexRemove(&sd->slots, page);
+    sd->lastTime[s] = sd->freeSlot;
+    sd->freeSlot = s;
+    sd->distinct--;
+}
+
+// Function to get the current stack depth of a page that has been accessed
+int stackDistanceDepth(const StackDistance *sd, int slot) {
+    return 1 + sd->distinct - fenwickPrefix(sd->tree, sd->lastTime[slot]);
+}
+
+// A trace loaded into memory
+typedef struct {
+    Page *pages;
+    int *pids; // Process id of each record, NULL unless the trace has a PID column
+    int count;
+    int capacity;
+} Trace;
+
+#define NO_PID -1
+
+// Function to append a record to the trace, growing it geometrically
+// The PID column is allocated at the first record that has one, the records before it belong to process 0
+static inline void traceAppend(Trace *trace, int page_number, int dirty, int pid) {
+    if (trace->count == trace->capacity) {
+        trace->capacity = trace->capacity < 1024 ? 1024 : 2 * trace->capacity;
+        trace->pages = realloc(trace->pages, trace->capacity * sizeof(Page));
+        if (trace->pages == NULL || (trace->pids != NULL &&
+                                     (trace->pids = realloc(trace->pids, trace->capacity * sizeof(int))) == NULL)) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (pid != NO_PID && trace->pids == NULL) {
+        trace->pids = calloc(trace->capacity, sizeof(int));
+        if (trace->pids == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (trace->pids != NULL) {
+        trace->pids[trace->count] = pid == NO_PID ? 0 : pid;
+    }
+    trace->pages[trace->count].page_number = page_number;
+    trace->pages[trace->count].dirty = dirty;
+    trace->count++;
+}
+
+// Function to parse one "page,dirty[,pid]" line that ends with '\n', returns false for headers and malformed lines
+// The pid is NO_PID when the line has no third column
+static inline bool parseTraceLine(const char *p, int *page_number, int *dirty, int *pid) {
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    unsigned int negative = *p == '-';
+    p += negative;
+
+    // Digits are accumulated without a bounds check, the newline (or comma) stops the loop
+    const char *digits = p;
+    unsigned int value = 0;
+    while ((unsigned int)(*p - '0') < 10) {
+        value = value * 10 + (unsigned int)(*p++ - '0');
+    }
+    if (p == digits) {
+        return false;
+    }
+
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p++ != ',') {
+        return false;
+    }
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+
+    digits = p;
+    unsigned int flag = 0;
+    while ((unsigned int)(*p - '0') < 10) {
+        flag = flag * 10 + (unsigned int)(*p++ - '0');
+    }
+    if (p == digits) {
+        return false;
+    }
+
+    // An optional third column names the process that made the reference
+    *pid = NO_PID;
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p == ',') {
+        p++;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        digits = p;
+        unsigned int process = 0;
+        while ((unsigned int)(*p - '0') < 10) {
+            process = process * 10 + (unsigned int)(*p++ - '0');
+        }
+        if (p == digits || process > INT_MAX) {
+            return false;
+        }
+        *pid = (int)process;
+    }
+
+    *page_number = (int)((value ^ -negative) + negative); // Two's complement negation without a branch
+    *dirty = (int)flag;
+    return true;
+}
+
+// Function to parse every complete line in data into the trace and return the number of bytes consumed
+// With final set, a last line without a newline is parsed too. Lines that are not "page,dirty[,pid]" records
+// (such as a header) are skipped, like the standalone drivers do.
+size_t parseTraceChunk(const char *data, size_t length, bool final, Trace *trace) {
+    const char *p = data;
+    const char *end = data + length;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p);
+        int page_number;
+        int dirty;
+        int pid;
+
+        if (eol == NULL) {
+            if (!final) {
+                break;
+            }
+            // Copy the unterminated last line so the parser can rely on a newline sentinel
+            char line[256];
+            size_t line_length = end - p < (long)sizeof(line) - 1 ? (size_t)(end - p) : sizeof(line) - 1;
+            memcpy(line, p, line_length);
+            line[line_length] = '\n';
+            if (parseTraceLine(line, &page_number, &dirty, &pid)) {
+                traceAppend(trace, page_number, dirty, pid);
+            }
+            p = end;
+            break;
+        }
+
+        if (parseTraceLine(p, &page_number, &dirty, &pid)) {
+            traceAppend(trace, page_number, dirty, pid);
+        }
+        p = eol + 1;
+    }
+    return p - data;
+}
+
+// Binary trace format. A 32-byte little-endian header is followed by the records and an optional block index.
+//   bytes 0-3   magic "PRTB"
+//   byte  4     format version (1)
+//   byte  5     record encoding, TRACE_FIXED or TRACE_VARINT
+//   byte  6     flags, TRACE_FLAG_PIDS when every record carries a process id
+//   byte  7     reserved
+//   bytes 8-15  record count
+//   bytes 16-19 records per block
+//   bytes 20-23 reserved
+//   bytes 24-31 file offset of the block index, 0 when there is none
+// TRACE_FIXED stores each record as one 32-bit word, page << 1 | dirty, and needs pages in 0..2^31-1.
+// TRACE_VARINT stores zigzag(page - previous page) << 1 | dirty as an LEB128 varint. The previous page
+// restarts at 0 on every block, and the index holds the 64-bit file offset of each block, so decoding can
+// begin at any block boundary. Only a dirty value of 1 is kept as dirty, which is all the simulators test for.
+// With TRACE_FLAG_PIDS the pid follows each record, as a second 32-bit word or as a plain LEB128 varint.
+#define TRACE_MAGIC "PRTB"
+#define TRACE_HEADER_SIZE 32
+#define TRACE_FIXED 0
+#define TRACE_VARINT 1
+#define TRACE_BLOCK_SIZE 65536
+#define TRACE_FLAG_PIDS 1
+
+static inline void storeLE(unsigned char *out, unsigned long long value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static inline unsigned long long loadLE(const unsigned char *in, int bytes) {
+    unsigned long long value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (unsigned long long)in[i] << (8 * i);
+    }
+    return value;
+}
+
+// Function to read one LEB128 varint at *p, returns false if it runs past end or overflows 64 bits
+static inline bool readVarint(const unsigned char **p, const unsigned char *end, unsigned long long *value) {
+    const unsigned char *q = *p;
+    int shift = 0;
+    *value = 0;
+    do {
+        if (q >= end || shift > 63) {
+            return false;
+        }
+        *value |= (unsigned long long)(*q & 0x7f) << shift;
+        shift += 7;
+    } while (*q++ & 0x80);
+    *p = q;
+    return true;
+}
+
+// Function to append value to record as an LEB128 varint and return the new length
+static inline int writeVarint(unsigned char *record, int length, unsigned long long value) {
+    do {
+        record[length++] = (unsigned char)((value & 0x7f) | (value > 0x7f ? 0x80 : 0));
+        value >>= 7;
+    } while (value != 0);
+    return length;
+}
+
+// Function to check whether data starts with a binary trace header
+bool isBinaryTrace(const unsigned char *data, size_t length) {
+    return length >= TRACE_HEADER_SIZE && memcmp(data, TRACE_MAGIC, 4) == 0;
+}
+
+// Function to decode a binary trace held in memory (usually a mapping of the file) into trace
+// Returns false if the data is truncated or uses an unknown version, encoding or flag
+bool decodeBinaryTrace(const unsigned char *data, size_t length, Trace *trace) {
+    unsigned long long count = loadLE(data + 8, 8);
+    unsigned long long block_size = loadLE(data + 16, 4);
+    unsigned long long index_offset = loadLE(data + 24, 8);
+    int encoding = data[5];
+    int flags = data[6];
+
+    if (data[4] != 1 || count > INT_MAX || (encoding != TRACE_FIXED && encoding != TRACE_VARINT) ||
+        (flags & ~TRACE_FLAG_PIDS) != 0) {
+        return false;
+    }
+
+    // The header is untrusted, so its sizes are checked against the data before anything is allocated.
+    // count is at most INT_MAX, which keeps record_size * count from overflowing.
+    int record_size = flags & TRACE_FLAG_PIDS ? 8 : 4;
+    unsigned long long blocks = block_size == 0 ? 0 : (count + block_size - 1) / block_size;
+    if (encoding == TRACE_FIXED) {
+        if (length < TRACE_HEADER_SIZE + record_size * count) {
+            return false;
+        }
+    } else if (block_size == 0 || index_offset < TRACE_HEADER_SIZE || index_offset > length ||
+               blocks > (length - index_offset) / 8 || count > index_offset - TRACE_HEADER_SIZE) {
+        return false; // Every varint record takes at least one byte before the index
+    }
+    trace->pages = checkedMalloc(count * sizeof(Page));
+    trace->pids = flags & TRACE_FLAG_PIDS ? checkedMalloc(count * sizeof(int)) : NULL;
+    trace->capacity = (int)count;
+    trace->count = 0;
+
+    if (encoding == TRACE_FIXED) {
+        // The words are unpacked straight out of the input without an intermediate copy
+        const unsigned char *word = data + TRACE_HEADER_SIZE;
+        for (unsigned long long i = 0; i < count; i++, word += record_size) {
+            unsigned int packed = (unsigned int)loadLE(word, 4);
+            trace->pages[i].page_number = (int)(packed >> 1);
+            trace->pages[i].dirty = (int)(packed & 1);
+        }
+        if (trace->pids != NULL) {
+            word = data + TRACE_HEADER_SIZE + 4;
+            for (unsigned long long i = 0; i < count; i++, word += record_size) {
+                unsigned int pid = (unsigned int)loadLE(word, 4);
+                if (pid > INT_MAX) {
+                    return false;
+                }
+                trace->pids[i] = (int)pid;
+            }
+        }
+        trace->count = (int)count;
+        return true;
+    }
+
+    const unsigned char *index = data + index_offset;
+    const unsigned char *end = data + index_offset; // Record bytes end where the index begins
+
+    for (unsigned long long block = 0; block < blocks; block++) {
+        unsigned long long offset = loadLE(index + 8 * block, 8);
+        if (offset < TRACE_HEADER_SIZE || offset >= index_offset) {
+            return false;
+        }
+        const unsigned char *p = data + offset;
+        unsigned long long first = block * block_size;
+        unsigned long long last = first + block_size < count ? first + block_size : count;
+        long long page = 0;
+
+        for (unsigned long long i = first; i < last; i++) {
+            unsigned long long value;
+            if (!readVarint(&p, end, &value)) {
+                return false;
+            }
+
+            unsigned long long zigzag = value >> 1;
+            page += (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+            trace->pages[i].page_number = (int)page;
+            trace->pages[i].dirty = (int)(value & 1);
+
+            if (trace->pids != NULL) {
+                unsigned long long pid;
+                if (!readVarint(&p, end, &pid) || pid > INT_MAX) {
+                    return false;
+                }
+                trace->pids[i] = (int)pid;
+            }
+        }
+    }
+    trace->count = (int)count;
+    return true;
+}
+
+// Function to write a trace in the binary format, returns false on an I/O error
+bool writeBinaryTrace(FILE *out, const Trace *trace, int encoding) {
+    unsigned char header[TRACE_HEADER_SIZE] = {0};
+    unsigned long long blocks = (trace->count + TRACE_BLOCK_SIZE - 1) / TRACE_BLOCK_SIZE;
+    unsigned long long *block_offsets = checkedMalloc((blocks + 1) * sizeof(unsigned long long));
+    unsigned long long offset = TRACE_HEADER_SIZE;
+    bool ok = true;
+
+    memcpy(header, TRACE_MAGIC, 4);
+    header[4] = 1;
+    header[5] = (unsigned char)encoding;
+    header[6] = trace->pids != NULL ? TRACE_FLAG_PIDS : 0;
+    storeLE(header + 8, trace->count, 8);
+    storeLE(header + 16, TRACE_BLOCK_SIZE, 4);
+    ok = fwrite(header, 1, sizeof(header), out) == sizeof(header);
+
+    for (int i = 0; ok && i < trace->count; i++) {
+        unsigned char record[20];
+        int length = 0;
+        unsigned int dirty = trace->pages[i].dirty == 1;
+
+        if (encoding == TRACE_FIXED) {
+            storeLE(record, (unsigned int)trace->pages[i].page_number << 1 | dirty, 4);
+            length = 4;
+            if (trace->pids != NULL) {
+                storeLE(record + 4, (unsigned int)trace->pids[i], 4);
+                length = 8;
+            }
+        } else {
+            if (i % TRACE_BLOCK_SIZE == 0) {
+                block_offsets[i / TRACE_BLOCK_SIZE] = offset;
+            }
+            long long previous = i % TRACE_BLOCK_SIZE == 0 ? 0 : trace->pages[i - 1].page_number;
+            long long delta = trace->pages[i].page_number - previous;
+            unsigned long long zigzag = ((unsigned long long)delta << 1) ^ (unsigned long long)(delta >> 63);
+            length = writeVarint(record, length, zigzag << 1 | dirty);
+            if (trace->pids != NULL) {
+                length = writeVarint(record, length, (unsigned int)trace->pids[i]);
+            }
+        }
+        ok = fwrite(record, 1, length, out) == (size_t)length;
+        offset += length;
+    }
+
+    if (ok && encoding == TRACE_VARINT) {
+        for (unsigned long long block = 0; ok && block < blocks; block++) {
+            unsigned char entry[8];
+            storeLE(entry, block_offsets[block], 8);
+            ok = fwrite(entry, 1, 8, out) == 8;
+        }
+        // Point the header at the index now that its offset is known
+        storeLE(header + 24, offset, 8);
+        ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), out) == sizeof(header);
+    }
+
+    free(block_offsets);
+    return ok && fflush(out) == 0;
+}
+
+// Function to convert the trace to the binary format, falling back to varints if a page does not fit a fixed word
+int convertTrace(const Trace *trace, const char *path, int encoding) {
+    for (int i = 0; encoding == TRACE_FIXED && i < trace->count; i++) {
+        if (trace->pages[i].page_number < 0) {
+            fprintf(stderr, "Note: negative page numbers need the varint encoding, using it instead.\n");
+            encoding = TRACE_VARINT;
+        }
+    }
+
+    FILE *out = fopen(path, "wb");
+    if (out == NULL) {
+        perror("Error: Cannot open the output trace");
+        return EXIT_FAILURE;
+    }
+    bool ok = writeBinaryTrace(out, trace, encoding);
+    if (fclose(out) != 0 || !ok) {
+        perror("Error: Cannot write the output trace");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Function to load a whole trace held in memory, CSV or binary, into an empty trace
+void loadTraceBytes(const void *data, size_t length, Trace *trace) {
+    if (!isBinaryTrace(data, length)) {
+        parseTraceChunk(data, length, true, trace);
+    } else if (!decodeBinaryTrace(data, length, trace)) {
+        fprintf(stderr, "Error: The binary trace is corrupt or unsupported.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to load a whole trace from a file descriptor in a single pass
+// Regular files are mapped and parsed in place. Pipes and terminals are read in large chunks into a
+// buffer that only grows when a single line does not fit, so rewinding the input is never needed.
+// Binary traces are recognised by their header and decoded directly, a piped one is buffered whole first.
+void loadTrace(int fd, Trace *trace) {
+    struct stat info;
+    trace->pages = NULL;
+    trace->pids = NULL;
+    trace->count = 0;
+    trace->capacity = 0;
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+            loadTraceBytes(mapped, info.st_size, trace);
+            munmap(mapped, info.st_size);
+            return;
+        }
+    }
+
+    size_t buffer_size = 1 << 20;
+    size_t filled = 0;
+    bool binary = false; // Binary input is kept whole in the buffer instead of being parsed line by line
+    char *buffer = checkedMalloc(buffer_size);
+    for (;;) {
+        if (filled == buffer_size) {
+            buffer_size *= 2; // A single line is longer than the buffer
+            buffer = realloc(buffer, buffer_size);
+            if (buffer == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        ssize_t got = read(fd, buffer + filled, buffer_size - filled);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            if (!binary) {
+                parseTraceChunk(buffer, filled, true, trace);
+            } else if (!decodeBinaryTrace((unsigned char *)buffer, filled, trace)) {
+                fprintf(stderr, "Error: The binary trace is corrupt or unsupported.\n");
+                exit(EXIT_FAILURE);
+            }
+            break;
+        }
+        bool at_start = trace->count == 0 && filled < TRACE_HEADER_SIZE;
+        filled += got;
+        if (at_start && filled >= TRACE_HEADER_SIZE) {
+            binary = isBinaryTrace((unsigned char *)buffer, filled);
+        }
+        if (binary || (at_start && filled < TRACE_HEADER_SIZE)) {
+            continue; // Wait for the whole binary trace, or for enough bytes to tell
+        }
+
+        // Parse the complete lines and keep the partial last line for the next read
+        size_t consumed = parseTraceChunk(buffer, filled, false, trace);
+        memmove(buffer, buffer + consumed, filled - consumed);
+        filled -= consumed;
+    }
+    free(buffer);
+}
+
+// Dense renumbering of the pages of a trace
+typedef struct {
+    int *original;     // Dense id -> original page number, for reporting
+    int unique;        // Number of distinct pages, the ids are 0..unique-1
+    int *originalPid;  // Dense process id -> original pid, NULL unless the trace has a PID column
+    int *owner;        // Dense page id -> dense id of the process it belongs to, NULL without a PID column
+    int processes;     // Number of distinct processes, the ids are 0..processes-1
+} PageRemap;
+
+// Open-addressing hash index from a 64-bit (process, page) key to a dense page id
+typedef struct {
+    unsigned long long *keys;
+    int *values;  // -1 marks an empty bucket
+    int mask;     // bucket count - 1, the bucket count is a power of two
+} PairIndex;
+
+void pairIndexInit(PairIndex *index, int buckets) {
+    index->keys = checkedMalloc(buckets * sizeof(unsigned long long));
+    index->values = checkedMalloc(buckets * sizeof(int));
+    index->mask = buckets - 1;
+    memset(index->values, -1, buckets * sizeof(int));
+}
+
+// Function to find the bucket holding key, or the empty bucket where it belongs
+static inline int pairIndexBucket(const PairIndex *index, unsigned long long key) {
+    int bucket = (int)((key * 0x9E3779B97F4A7C15ull) >> 40) & index->mask;
+    while (index->values[bucket] != -1 && index->keys[bucket] != key) {
+        bucket = (bucket + 1) & index->mask;
+    }
+    return bucket;
+}
+
+// Function to double the bucket count, reinserting every key
+void pairIndexGrow(PairIndex *index) {
+    PairIndex grown;
+    pairIndexInit(&grown, 2 * (index->mask + 1));
+    for (int bucket = 0; bucket <= index->mask; bucket++) {
+        if (index->values[bucket] != -1) {
+            int target = pairIndexBucket(&grown, index->keys[bucket]);
+            grown.keys[target] = index->keys[bucket];
+            grown.values[target] = index->values[bucket];
+        }
+    }
+    free(index->keys);
+    free(index->values);
+    *index = grown;
+}
+
+// Function to grow an int array to capacity entries or abort
+static int *growArray(int *array, int capacity) {
+    array = realloc(array, capacity * sizeof(int));
+    if (array == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// Function to renumber a trace with a PID column, where equal page numbers of different processes are
+// different pages. Each (process, page) pair gets its own dense id, the processes are renumbered densely in
+// order of first reference as well, and the pids are rewritten to those process ids.
+static void remapProcessTrace(Trace *trace, PageRemap *remap) {
+    PageIndex processes; // Original pid -> dense process id
+    int process_capacity = 64;
+    pageIndexInit(&processes, process_capacity);
+    remap->originalPid = checkedMalloc(process_capacity * sizeof(int));
+    remap->processes = 0;
+
+    PairIndex ids; // (process, original page) -> dense id, kept at most half full
+    int capacity = 1024;
+    pairIndexInit(&ids, 2 * capacity);
+    remap->original = checkedMalloc(capacity * sizeof(int));
+    remap->owner = checkedMalloc(capacity * sizeof(int));
+    remap->unique = 0;
+
+    for (int i = 0; i < trace->count; i++) {
+        int pid = trace->pids[i];
+        int process = pageIndexFind(&processes, pid);
+        if (process == -1) {
+            process = remap->processes++;
+            if (process == process_capacity) {
+                process_capacity *= 2;
+                remap->originalPid = growArray(remap->originalPid, process_capacity);
+            }
+            remap->originalPid[process] = pid;
+            pageIndexInsert(&processes, pid, process);
+        }
+
+        int page = trace->pages[i].page_number;
+        unsigned long long key = (unsigned long long)process << 32 | (unsigned int)page;
+        int bucket = pairIndexBucket(&ids, key);
+        int id = ids.values[bucket];
+        if (id == -1) {
+            id = remap->unique++;
+            if (id == capacity) {
+                capacity *= 2;
+                remap->original = growArray(remap->original, capacity);
+                remap->owner = growArray(remap->owner, capacity);
+                pairIndexGrow(&ids);
+                bucket = pairIndexBucket(&ids, key);
+            }
+            ids.keys[bucket] = key;
+            ids.values[bucket] = id;
+            remap->original[id] = page;
+            remap->owner[id] = process;
+        }
+        trace->pages[i].page_number = id;
+        trace->pids[i] = process;
+    }
+    pageIndexFree(&processes);
+    free(ids.keys);
+    free(ids.values);
+}
+
+// Function to renumber the trace's pages in place to dense ids in order of first reference
+// Engines given the universe size then index pages with flat arrays instead of hashing. A trace with a PID
+// column gives every process its own address space, so the single-pool policies then simulate global replacement.
+void remapTrace(Trace *trace, PageRemap *remap) {
+    if (trace->pids != NULL) {
+        remapProcessTrace(trace, remap);
+        return;
+    }
+    PageIndex ids; // Original page number -> dense id
+    int capacity = 1024;
+    pageIndexInit(&ids, capacity);
+    remap->original = checkedMalloc(capacity * sizeof(int));
+    remap->unique = 0;
+
+    for (int i = 0; i < trace->count; i++) {
+        int page = trace->pages[i].page_number;
+        int id = pageIndexFind(&ids, page);
+        if (id == -1) {
+            id = remap->unique++;
+            if (id == capacity) {
+                capacity *= 2;
+                remap->original = realloc(remap->original, capacity * sizeof(int));
+                if (remap->original == NULL) {
+                    fprintf(stderr, "Error: Memory allocation failed\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            remap->original[id] = page;
+            pageIndexInsert(&ids, page, id);
+        }
+        trace->pages[i].page_number = id;
+    }
+    pageIndexFree(&ids);
+}
+
+// Function to find, for every reference, the index of the next reference to the same page (count if there is none)
+// One backward sweep over the trace replaces the forward scan the optimal algorithm used to do on every fault
+// With dense page ids (universe > 0) the sweep keeps its positions in a flat array instead of a hash index
+int *buildNextUse(Page pages[], int count, int universe) {
+    int *next_use = checkedMalloc(count * sizeof(int));
+    if (universe > 0) {
+        int *upcoming = checkedMalloc(universe * sizeof(int)); // Page id -> earliest reference after the sweep position
+        for (int page = 0; page < universe; page++) {
+            upcoming[page] = count; // Never referenced again
+        }
+        for (int i = count - 1; i >= 0; i--) {
+            next_use[i] = upcoming[pages[i].page_number];
+            upcoming[pages[i].page_number] = i;
+        }
+        free(upcoming);
+        return next_use;
+    }
+
+    PageIndex upcoming; // Page number -> index of its earliest reference after the sweep position
+    pageIndexInit(&upcoming, 1024);
+
+    for (int i = count - 1; i >= 0; i--) {
+        int next = pageIndexFind(&upcoming, pages[i].page_number);
+        if (next == -1) {
+            next_use[i] = count; // Never referenced again
+            pageIndexInsert(&upcoming, pages[i].page_number, i);
+        } else {
+            next_use[i] = next;
+            pageIndexUpdate(&upcoming, pages[i].page_number, i);
+        }
+    }
+
+    pageIndexFree(&upcoming);
+    return next_use;
+}
+
+// Preprocessing cache (--cache DIR). Parsing, remapping and the next-use index depend only on the trace's
+// bytes, so they are saved in DIR under a hash of those bytes and later runs on the same trace map the file
+// instead of redoing them. The file is a 128-byte header followed by 64-byte aligned arrays in the host's
+// own layout, which the engines use in place:
+//   bytes 0-7     magic "PRCACHE" and format version (1)
+//   bytes 8-15    content hash of the trace
+//   bytes 16-23   length of the trace in bytes
+//   bytes 24-31   record count
+//   bytes 32-39   distinct pages
+//   bytes 40-47   distinct processes, 0 without a PID column
+//   bytes 48-55   sizeof(Page), so a cache from an incompatible build is rebuilt
+//   bytes 56-103  file offsets of the records (remapped), next-use index, original page numbers, pids,
+//                 original pids and page owners, 0 for the last three without a PID column
+// A cache is written to a temporary name and renamed into place, so concurrent runs never see half a file.
+#define CACHE_MAGIC "PRCACHE\1"
+#define CACHE_HEADER_SIZE 128
+#define CACHE_ARRAYS 6
+
+// A trace whose preprocessing was mapped from the cache, NULL mapping when it lives on the heap
+typedef struct {
+    void *mapping;
+    size_t length;
+} TraceCache;
+
+// Function to hash the trace's bytes, four independent multiply-xorshift lanes keep it near memory speed
+unsigned long long contentHash(const unsigned char *data, size_t length) {
+    unsigned long long lanes[4] = {0x9e3779b97f4a7c15ull, 0xbf58476d1ce4e5b9ull, 0x94d049bb133111ebull, length};
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            unsigned long long word;
+            memcpy(&word, data + i + 8 * lane, 8);
+            lanes[lane] = (lanes[lane] ^ word) * 0xff51afd7ed558ccdull;
+            lanes[lane] ^= lanes[lane] >> 32;
+        }
+    }
+    unsigned long long hash = lanes[0] ^ (lanes[1] << 1 | lanes[1] >> 63) ^ (lanes[2] << 2 | lanes[2] >> 62) ^
+                              (lanes[3] << 3 | lanes[3] >> 61);
+    for (; i < length; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    hash = (hash ^ (hash >> 33)) * 0xc4ceb9fe1a85ec53ull;
+    return hash ^ (hash >> 33);
+}
+
+// Function to map a cache file and point the trace, remap and next-use index into it
+// Returns false if the file is missing or does not belong to this trace and build.
+static bool cacheMap(const char *path, unsigned long long hash, size_t trace_length, Trace *trace,
+                     PageRemap *remap, int **next_use, TraceCache *cache) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &info) != 0 || info.st_size < CACHE_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+    // Private and writable so an engine writing to its input only touches its own copy of the page
+    unsigned char *data = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    unsigned long long count = loadLE(data + 24, 8);
+    unsigned long long unique = loadLE(data + 32, 8);
+    unsigned long long processes = loadLE(data + 40, 8);
+    unsigned long long offsets[CACHE_ARRAYS];
+    unsigned long long sizes[CACHE_ARRAYS] = {count * sizeof(Page), count * sizeof(int), unique * sizeof(int),
+                                              count * sizeof(int), processes * sizeof(int), unique * sizeof(int)};
+    bool valid = memcmp(data, CACHE_MAGIC, 8) == 0 && loadLE(data + 8, 8) == hash &&
+                 loadLE(data + 16, 8) == trace_length && loadLE(data + 48, 8) == sizeof(Page) &&
+                 count <= INT_MAX && unique <= INT_MAX && processes <= INT_MAX;
+    for (int a = 0; valid && a < CACHE_ARRAYS; a++) {
+        offsets[a] = loadLE(data + 56 + 8 * a, 8);
+        bool present = offsets[a] != 0;
+        valid = (present || (a >= 3 && processes == 0)) && offsets[a] % 64 == 0 &&
+                offsets[a] + (present ? sizes[a] : 0) <= (unsigned long long)info.st_size;
+    }
+    if (!valid) {
+        munmap(data, info.st_size);
+        return false;
+    }
+
+    trace->pages = (Page *)(data + offsets[0]);
+    trace->count = (int)count;
+    trace->capacity = (int)count;
+    trace->pids = processes > 0 ? (int *)(data + offsets[3]) : NULL;
+    *next_use = (int *)(data + offsets[1]);
+    remap->original = (int *)(data + offsets[2]);
+    remap->unique = (int)unique;
+    remap->processes = (int)processes;
+    remap->originalPid = processes > 0 ? (int *)(data + offsets[4]) : NULL;
+    remap->owner = processes > 0 ? (int *)(data + offsets[5]) : NULL;
+    cache->mapping = data;
+    cache->length = info.st_size;
+    return true;
+}
+
+// Function to write the preprocessed trace to path, returns false on an I/O error
+static bool cacheWrite(const char *path, unsigned long long hash, size_t trace_length, const Trace *trace,
+                       const PageRemap *remap, const int *next_use) {
+    char temporary[4096];
+    if (snprintf(temporary, sizeof(temporary), "%s.%d.tmp", path, (int)getpid()) >= (int)sizeof(temporary)) {
+        return false;
+    }
+    FILE *out = fopen(temporary, "wb");
+    if (out == NULL) {
+        return false;
+    }
+
+    bool pids = trace->pids != NULL;
+    const void *arrays[CACHE_ARRAYS] = {trace->pages, next_use, remap->original, trace->pids, remap->originalPid,
+                                        remap->owner};
+    unsigned long long sizes[CACHE_ARRAYS] = {trace->count * sizeof(Page), trace->count * sizeof(int),
+                                              remap->unique * sizeof(int), trace->count * sizeof(int),
+                                              remap->processes * sizeof(int), remap->unique * sizeof(int)};
+    unsigned char header[CACHE_HEADER_SIZE] = {0};
+    memcpy(header, CACHE_MAGIC, 8);
+    storeLE(header + 8, hash, 8);
+    storeLE(header + 16, trace_length, 8);
+    storeLE(header + 24, trace->count, 8);
+    storeLE(header + 32, remap->unique, 8);
+    storeLE(header + 40, pids ? remap->processes : 0, 8);
+    storeLE(header + 48, sizeof(Page), 8);
+    unsigned long long offset = CACHE_HEADER_SIZE;
+    for (int a = 0; a < CACHE_ARRAYS; a++) {
+        if (a < 3 || pids) {
+            storeLE(header + 56 + 8 * a, offset, 8);
+            offset = (offset + sizes[a] + 63) / 64 * 64;
+        }
+    }
+
+    static const unsigned char padding[64];
+    bool ok = fwrite(header, 1, sizeof(header), out) == sizeof(header);
+    offset = CACHE_HEADER_SIZE;
+    for (int a = 0; ok && a < CACHE_ARRAYS; a++) {
+        if (a < 3 || pids) {
+            size_t pad = (size_t)((offset + sizes[a] + 63) / 64 * 64 - offset - sizes[a]);
+            ok = fwrite(arrays[a], 1, sizes[a], out) == sizes[a] && fwrite(padding, 1, pad, out) == pad;
+            offset += sizes[a] + pad;
+        }
+    }
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(temporary, path) != 0) {
+        unlink(temporary);
+        return false;
+    }
+    return true;
+}
+
+// Function to load the trace on fd through the cache in dir: a hit maps the remapped records, the remap and
+// the next-use index, a miss loads and preprocesses the trace as usual and saves the result for next time
+// Returns false, having done nothing, when fd is not a regular file, since a pipe cannot be hashed before it
+// is consumed. Otherwise the trace comes back remapped with its next-use index.
+bool loadCachedTrace(int fd, const char *dir, Trace *trace, PageRemap *remap, int **next_use, TraceCache *cache) {
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        return false;
+    }
+    void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+    unsigned long long hash = contentHash(mapped, info.st_size);
+
+    char path[4096];
+    if (snprintf(path, sizeof(path), "%s/%016llx.prcache", dir, hash) >= (int)sizeof(path)) {
+        fprintf(stderr, "Error: The cache directory path is too long.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (cacheMap(path, hash, info.st_size, trace, remap, next_use, cache)) {
+        munmap(mapped, info.st_size);
+        return true;
+    }
+
+    *trace = (Trace){NULL, NULL, 0, 0};
+    loadTraceBytes(mapped, info.st_size, trace);
+    munmap(mapped, info.st_size);
+    remapTrace(trace, remap);
+    *next_use = buildNextUse(trace->pages, trace->count, remap->unique);
+    if (!cacheWrite(path, hash, info.st_size, trace, remap, *next_use)) {
+        fprintf(stderr, "Note: Cannot write the cache file %s: %s\n", path, strerror(errno));
+    }
+    return true;
+}
+
+// Function to release a trace and its preprocessing, whether they live on the heap or in a cache mapping
+void releaseTrace(Trace *trace, PageRemap *remap, int *next_use, TraceCache *cache) {
+    if (cache->mapping != NULL) {
+        munmap(cache->mapping, cache->length);
+        return;
+    }
+    free(trace->pages);
+    free(trace->pids);
+    free(next_use);
+    free(remap->original);
+    free(remap->originalPid);
+    free(remap->owner);
+}
+
+// Heap order for the optimal algorithm: the frame whose page is used farthest in the future comes first,
+// ties (pages never used again and empty frames) go to the lowest frame index
+static inline bool evictsBefore(const int *next_use_of, int a, int b) {
+    return next_use_of[a] > next_use_of[b] || (next_use_of[a] == next_use_of[b] && a < b);
+}
+
+static void heapSiftUp(int *heap, int *heap_pos, const int *next_use_of, int pos) {
+    int frame = heap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!evictsBefore(next_use_of, frame, heap[parent])) {
+            break;
+        }
+        heap[pos] = heap[parent];
+        heap_pos[heap[pos]] = pos;
+        pos = parent;
+    }
+    heap[pos] = frame;
+    heap_pos[frame] = pos;
+}
+
+static void heapSiftDown(int *heap, int *heap_pos, const int *next_use_of, int size, int pos) {
+    int frame = heap[pos];
+    while (2 * pos + 1 < size) {
+        int child = 2 * pos + 1;
+        if (child + 1 < size && evictsBefore(next_use_of, heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!evictsBefore(next_use_of, heap[child], frame)) {
+            break;
+        }
+        heap[pos] = heap[child];
+        heap_pos[heap[pos]] = pos;
+        pos = child;
+    }
+    heap[pos] = frame;
+    heap_pos[frame] = pos;
+}
+
+// Policies the drivers can simulate
+typedef enum {
+    POLICY_FIFO,
+    POLICY_LRU,
+    POLICY_OPT,
+    POLICY_SC,
+    POLICY_ARC,
+    POLICY_WTINYLFU
+} Policy;
+
+// Parameters shared by every simulation of a run
+typedef struct {
+    int aging_bits;    // Second Chance reference register width (n)
+    int aging_period;  // Second Chance references between register shifts (m)
+    int universe;      // Number of dense page ids when the trace was remapped, 0 for raw page numbers
+    const int *original; // Original page number of each dense id, NULL for raw page numbers
+    bool compact;      // Index dense ids with pageIndexInitCompact, set by the fused sweep
+} SimOptions;
+
+// FIFO simulation state, references can be fed to fifoRun in any number of chunks
+typedef struct {
+    Page *frames;         // Page held by each frame
+    PageIndex index;      // Page number -> frame holding it
+    int frame_count;
+    int frame_index;      // Index for the FIFO replacement
+    int page_faults;      // Count of page faults
+    int writeBacks;
+#ifdef PR_STATS
+    RunStats stats;
+#endif
+} FifoState;
+
+void fifoInit(FifoState *state, int frame_count, int universe, bool compact) {
+    state->frames = checkedMalloc(frame_count * sizeof(Page)); // creates array of frames with size of frame_count 
+    state->frame_count = frame_count;
+    state->frame_index = 0;
+    state->page_faults = 0;
+    state->writeBacks = 0;
+    STAT_ATTACH(*state, (RunStats){0});
+
+    // Initialize frames
+    for (int i = 0; i < frame_count; i++) {
+        state->frames[i].page_number = -1; // fill the frame with empty pages
+        state->frames[i].dirty = 0;
+    }
+    pageIndexInitPool(&state->index, frame_count, universe, compact);
+}
+
+// FIFO Page Replacement Algorithm
+// A page -> frame hash index makes the residency check and the dirty update a single probe, the circular frame_index is the eviction order
+static inline void fifoStep(FifoState *state, Page current_page) {
+    Page *frames = state->frames;
+    int slot = pageIndexFind(&state->index, current_page.page_number);
+
+    // Check if the current page is already in the frames
+    if (slot == -1) {
+        // Page fault occurs
+        state->page_faults++;
+
+        int frame_index = state->frame_index;
+        STAT_ADD(state->stats, victim_search, 1);
+        if (frames[frame_index].page_number != -1) {
+            STAT_ADD(state->stats, evictions, 1);
+            // if a dirty page is evicted from memory, add one to writeBacks
+            if (frames[frame_index].dirty == 1) {
+                state->writeBacks++;       
+            }
+            pageIndexRemove(&state->index, frames[frame_index].page_number);
+        }
+
+        // Replace the page using FIFO method
+        frames[frame_index] = current_page;
+        pageIndexInsert(&state->index, current_page.page_number, frame_index);
+        state->frame_index = (frame_index + 1) % state->frame_count; // Move to the next frame in a circular manner
+
+    } else if (frames[slot].dirty == 0 && current_page.dirty == 1) {
+        // if the page is present, but the dirty bit is different
+        frames[slot].dirty = 1;
+    }
+}
+
+// Function to simulate a chunk of references, one fifoStep each
+void fifoRun(FifoState *state, const Page pages[], int count) {
+    STAT_RUN_BEGIN();
+    for (int i = 0; i < count; i++) {
+        fifoStep(state, pages[i]);
+    }
+    STAT_RUN_END(state->stats, count);
+}
+
+// Function to release the simulation state and return its counts
+SimResult fifoFinish(FifoState *state) {
+    pageIndexFree(&state->index);
+    free(state->frames); // Free the frame memory
+    SimResult result = {.frame_count = state->frame_count, .page_faults = state->page_faults, .writeBacks = state->writeBacks};
+    STAT_ATTACH(result, state->stats);
+    return result;
+}
+
+// signature contains: a list of pages read from the input file, counter that counts the number of pages, frame count for number of frames available 
+SimResult FIFO(Page pages[], int count, int frame_count) {
+    FifoState state;
+    fifoInit(&state, frame_count, 0, false);
+    fifoRun(&state, pages, count);
+    return fifoFinish(&state);
+}
+
+// Optimal Page Replacement Algorithm
+// Frames sit in a max-heap keyed on the next use of their page, so the victim is always the heap root and
+// each reference costs O(log frame_count). next_use comes from buildNextUse.
+SimResult Optimal(Page pages[], int count, int frame_count, const int *next_use) {
+    int *dirty = checkedMalloc(frame_count * sizeof(int)); // Dirty bit of the page in each frame
+    int *next_use_of = checkedMalloc(frame_count * sizeof(int)); // Next reference to the page in each frame, count if none
+    int *heap = checkedMalloc(frame_count * sizeof(int)); // Frames ordered by evictsBefore
+    int *heap_pos = checkedMalloc(frame_count * sizeof(int)); // Position of each frame in the heap
+    int *owner = checkedMalloc(count * sizeof(int)); // owner[j] is the frame holding the page referenced at j, -1 if not resident
+    int page_faults = 0;  // Count of page faults
+    int writeBacks = 0;
+#ifdef PR_STATS
+    RunStats stats = {0};
+    bool *occupied = checkedMalloc(frame_count * sizeof(bool)); // Tells evictions from filling empty frames
+    memset(occupied, 0, frame_count * sizeof(bool));
+#endif
+    STAT_RUN_BEGIN();
+    
+    // Initialize frames, every empty frame is a candidate that is never used
+    for (int i = 0; i < frame_count; i++) {
+        dirty[i] = 0;
+        next_use_of[i] = count;
+        heap[i] = i;
+        heap_pos[i] = i;
+    }
+    for (int j = 0; j < count; j++) {
+        owner[j] = -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int frame = owner[i];
+
+        // Check if the current page is already in the frames
+        if (frame == -1) {
+            // Page fault occurs
+            page_faults++;
+
+            // The root of the heap is the page that will not be used for the longest time
+            frame = heap[0];
+            STAT_ADD(stats, victim_search, 1);
+#ifdef PR_STATS
+            stats.evictions += occupied[frame];
+            occupied[frame] = true;
+#endif
+            
+            // Check if there is a need to write back a dirty page
+            if (dirty[frame] == 1) {
+                writeBacks++;
+            }
+            if (next_use_of[frame] < count) {
+                owner[next_use_of[frame]] = -1;
+            }
+
+            // Replace the page in the frame, its next use can only be sooner than the evicted one's
+            dirty[frame] = pages[i].dirty;
+            next_use_of[frame] = next_use[i];
+            heapSiftDown(heap, heap_pos, next_use_of, frame_count, 0);
+        }  else {
+
+            // if the page is present, but the dirty bit is different
+            if (dirty[frame] == 0 && pages[i].dirty == 1) {
+                dirty[frame] = 1;
+            }
+
+            // The page's next use moves further into the future
+            next_use_of[frame] = next_use[i];
+            heapSiftUp(heap, heap_pos, next_use_of, heap_pos[frame]);
+        }
+
+        if (next_use[i] < count) {
+            owner[next_use[i]] = frame;
+        }
+    }
+
+    free(dirty);
+    free(next_use_of);
+    free(heap);
+    free(heap_pos);
+    free(owner);
+
+    SimResult result = {.frame_count = frame_count, .page_faults = page_faults, .writeBacks = writeBacks};
+    STAT_RUN_END(stats, count);
+    STAT_ATTACH(result, stats);
+#ifdef PR_STATS
+    free(occupied);
+#endif
+    return result;
+}
+
+// Entry of the Belady priority stack used by OptimalStack
+typedef struct {
+    int next_use;    // Next reference to the page, count if it is never used again
+    int last_use;    // Most recent reference to the page, orders pages that are never used again
+    int dirty_from;  // Smallest pool whose copy of the page is dirty, INT_MAX if none
+} OptStackEntry;
+
+// Priority of the optimal stack: the page used sooner stays higher, among pages never used again the more recent one
+static inline bool optStackOutranks(const OptStackEntry *a, const OptStackEntry *b) {
+    return a->next_use < b->next_use || (a->next_use == b->next_use && a->last_use > b->last_use);
+}
+
+// Function to add the pools in [low, min(high, max_frames)] to a write-back difference array
+static inline void addWriteBackRange(long long *writeBacks, int max_frames, int low, int high) {
+    if (high > max_frames) {
+        high = max_frames;
+    }
+    if (low <= high) {
+        writeBacks[low]++;
+        writeBacks[high + 1]--;
+    }
+}
+
+// Optimal for every frame count 1..max_frames in a single pass over the trace
+// OPT is a stack algorithm: the top c entries of the priority stack are exactly the pages an optimal pool of
+// c frames holds. On each reference the page moves to the top and the displaced entries sift down, each
+// position keeping the higher priority of the carried entry and its current one. Only the top max_frames
+// entries are kept, which makes a reference cost O(max_frames) at worst.
+// Fault counts match Optimal(). Write-backs are exact for this stack, but when several resident pages are
+// never used again Optimal() evicts by frame position, so its write-back counts can differ slightly.
+void OptimalStack(Page pages[], int count, int max_frames, const int *next_use) {
+    OptStackEntry *stack = checkedMalloc(max_frames * sizeof(OptStackEntry)); // stack[0] is the top
+    long long *faults = calloc(max_frames + 2, sizeof(long long)); // Histogram of stack distances, then faults per pool
+    long long *writeBacks = calloc(max_frames + 2, sizeof(long long)); // Difference array, then write backs per pool
+    int depth = 0; // Entries currently on the stack
+
+    if (faults == NULL || writeBacks == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < count; i++) {
+        // Every entry's priority is its next use, so the current page is the entry whose next use is now
+        OptStackEntry carry = depth > 0 ? stack[0] : (OptStackEntry){0, 0, 0};
+        OptStackEntry current = {next_use[i], i, INT_MAX};
+        int distance = 0; // Stack distance of the reference, 0 if it misses every pool
+
+        if (depth > 0 && stack[0].next_use == i) {
+            distance = 1;
+            current.dirty_from = stack[0].dirty_from;
+        } else {
+            int pos;
+            for (pos = 1; pos < depth; pos++) {
+                if (stack[pos].next_use == i) {
+                    break;
+                }
+                if (optStackOutranks(&carry, &stack[pos])) {
+                    OptStackEntry lower = carry;
+                    carry = stack[pos];
+                    stack[pos] = lower;
+                }
+            }
+
+            if (pos < depth) {
+                distance = pos + 1;
+                current.dirty_from = stack[pos].dirty_from;
+                stack[pos] = carry;
+            } else if (depth < max_frames) {
+                if (depth > 0) {
+                    stack[depth] = carry;
+                }
+                depth++;
+            } else {
+                // The carried entry drops below the deepest pool, which evicts it from every pool
+                addWriteBackRange(writeBacks, max_frames, carry.dirty_from, max_frames);
+            }
+        }
+
+        if (distance == 0) {
+            faults[max_frames + 1]++;
+        } else {
+            faults[distance]++;
+            // Pools in [dirty_from, distance - 1] evicted a dirty copy of this page since its last reference
+            addWriteBackRange(writeBacks, max_frames, current.dirty_from, distance - 1);
+            if (current.dirty_from < distance) {
+                current.dirty_from = distance;
+            }
+        }
+        if (pages[i].dirty == 1) {
+            current.dirty_from = 1;
+        }
+        stack[0] = current;
+    }
+
+    // Pages still on the stack were evicted only from pools smaller than their final depth
+    for (int pos = 0; pos < depth; pos++) {
+        addWriteBackRange(writeBacks, max_frames, stack[pos].dirty_from, pos);
+    }
+
+    // A pool of c frames faults on every reference with distance greater than c
+    long long missing = faults[max_frames + 1];
+    long long running = 0;
+    for (int c = max_frames; c >= 1; c--) {
+        long long hits_at_c = faults[c];
+        faults[c] = missing;
+        missing += hits_at_c;
+    }
+    for (int c = 1; c <= max_frames; c++) {
+        running += writeBacks[c];
+        printf("| %-6d | %-12lld | %-11lld |\n", c, faults[c], running);
+        printf("+--------+--------------+-------------+\n");
+    }
+
+    free(stack);
+    free(faults);
+    free(writeBacks);
+}
+
+// LRU simulation state, references can be fed to lruRun in any number of chunks
+typedef struct {
+    int *frames;      //Page held by each frame
+    int *dirty_bits;  //Array to track the dirty bits for frames
+    int *prev;        //Recency list links towards the most recently used frame
+    int *next;        //Recency list links towards the least recently used frame
+    FrameList recency; //Head is the most recently used frame, tail the least recently used
+    PageIndex index;  //Page number -> frame holding it
+    int frame_count;
+    int used_frames;  //Frames filled so far, empty frames are used before anything is evicted
+    int page_faults;  //number of page faults
+    int writeBacks;
+#ifdef PR_STATS
+    RunStats stats;
+#endif
+} LruState;
+
+void lruInit(LruState *state, int frame_count, int universe, bool compact) {
+    state->frames = checkedMalloc(frame_count * sizeof(int));
+    state->dirty_bits = checkedMalloc(frame_count * sizeof(int));
+    state->prev = checkedMalloc(frame_count * sizeof(int));
+    state->next = checkedMalloc(frame_count * sizeof(int));
+    frameListInit(&state->recency);
+    pageIndexInitPool(&state->index, frame_count, universe, compact);
+    state->frame_count = frame_count;
+    state->used_frames = 0;
+    state->page_faults = 0;
+    state->writeBacks = 0;
+    STAT_ATTACH(*state, (RunStats){0});
+}
+
+// LRU Page Replacement Algorithm
+// Residency is a hash lookup and the recency order is a linked list, so every reference costs O(1)
+static inline void lruStep(LruState *state, Page reference) {
+    int *frames = state->frames;
+    int *dirty_bits = state->dirty_bits;
+    int current_page = reference.page_number; //Get the current page number from the list of pages
+    int current_dirty = reference.dirty; //Get the current page dirty status
+    int page_index = pageIndexFind(&state->index, current_page); //Current page in the frame
+
+    if (page_index == -1) { //Page fault occurs
+        state->page_faults++;
+
+        if (state->used_frames < state->frame_count) {
+            page_index = state->used_frames++; //Fill an empty frame
+        } else {
+            //Evict the least recently used page
+            page_index = state->recency.tail;
+            STAT_ADD(state->stats, victim_search, 1);
+            STAT_ADD(state->stats, evictions, 1);
+            if (dirty_bits[page_index] == 1) {
+                state->writeBacks++;
+            }
+            pageIndexRemove(&state->index, frames[page_index]);
+            frameListUnlink(&state->recency, state->prev, state->next, page_index);
+        }
+
+        //Load the current page into the frame
+        frames[page_index] = current_page;
+        dirty_bits[page_index] = current_dirty;
+        pageIndexInsert(&state->index, current_page, page_index);
+    } else {
+        frameListUnlink(&state->recency, state->prev, state->next, page_index);
+
+        //Update the dirty bit 
+        if (dirty_bits[page_index] == 0 && current_dirty == 1) {
+            dirty_bits[page_index] = 1;
+        }
+    }
+
+    frameListPushFront(&state->recency, state->prev, state->next, page_index); //The current page is now the most recently used
+}
+
+// Function to simulate a chunk of references, one lruStep each
+void lruRun(LruState *state, const Page pages[], int count) {
+    STAT_RUN_BEGIN();
+    for (int i = 0; i < count; i++) {  //Iterate through all of the pages
+        lruStep(state, pages[i]);
+    }
+    STAT_RUN_END(state->stats, count);
+}
+
+// Function to release the simulation state and return its counts
+SimResult lruFinish(LruState *state) {
+    pageIndexFree(&state->index);
+    free(state->frames);
+    free(state->dirty_bits);
+    free(state->prev);
+    free(state->next);
+    SimResult result = {.frame_count = state->frame_count, .page_faults = state->page_faults, .writeBacks = state->writeBacks};
+    STAT_ATTACH(result, state->stats);
+    return result;
+}
+
+SimResult LRU(Page pages[], int count, int frame_count) {
+    LruState state;
+    lruInit(&state, frame_count, 0, false);
+    lruRun(&state, pages, count);
+    return lruFinish(&state);
+}
+
+// Second Chance simulation state, a port of simulate_second_chance from secondChance.c
+typedef struct {
+    int *frames;                 //Page held by each frame, -1 when empty
+    unsigned int *ref_registers; //Reference register of n bits for each frame
+    int *dirty;
+    PageIndex index;             //Page number -> frame holding it
+    int frame_count;
+    int clock_hand;              //FIFO position used when every register is equal
+    int reference_count;         //References since the last register shift
+    int aging_period;            //References between register shifts (m)
+    unsigned int leftmost_bit;
+    unsigned int register_mask;  //Keeps only the n bits in a register
+    int page_faults;
+    int writeBacks;
+#ifdef PR_STATS
+    RunStats stats;
+#endif
+} SecondChanceState;
+
+void secondChanceInit(SecondChanceState *state, int frame_count, int aging_bits, int aging_period, int universe, bool compact) {
+    state->frames = checkedMalloc(frame_count * sizeof(int));
+    state->ref_registers = checkedMalloc(frame_count * sizeof(unsigned int));
+    state->dirty = checkedMalloc(frame_count * sizeof(int));
+    pageIndexInitPool(&state->index, frame_count, universe, compact);
+    state->frame_count = frame_count;
+    state->clock_hand = 0;
+    state->reference_count = 0;
+    state->aging_period = aging_period;
+    state->leftmost_bit = 1u << (aging_bits - 1);
+    state->register_mask = aging_bits >= 32 ? ~0u : (1u << aging_bits) - 1;
+    state->page_faults = 0;
+    state->writeBacks = 0;
+    STAT_ATTACH(*state, (RunStats){0});
+
     for (int i = 0; i < frame_count; i++) {
-        if (frames[i].page_number == page.page_number) {  
+        state->frames[i] = -1;  //This is an empty frame
+        state->ref_registers[i] = 0;
+        state->dirty[i] = 0;
+    }
+}
+
+//Function to find the replacement frame: the lowest reference register, or FIFO order when they are all equal
+int secondChanceVictim(SecondChanceState *state) {
+    const unsigned int *registers = state->ref_registers;
+    int lowest_index = 0;
+    bool all_equal = true;
+    STAT_ADD(state->stats, victim_search, state->frame_count);
+    for (int i = 1; i < state->frame_count; i++) {
+        if (registers[i] != registers[0]) {
+            all_equal = false;
+        }
+        if (registers[i] < registers[lowest_index]) {
+            lowest_index = i;
+        }
+    }
+
+    if (all_equal) {
+        int oldest_index = state->clock_hand;
+        state->clock_hand = (state->clock_hand + 1) % state->frame_count;
+        return oldest_index;
+    }
+    return lowest_index;
+}
+
+//Second Chance (aging) Page Replacement Algorithm
+static inline void secondChanceStep(SecondChanceState *state, Page reference) {
+    int page_number = reference.page_number;
+    int dirty_bit = reference.dirty;
+    int page_index = pageIndexFind(&state->index, page_number);
+
+    if (page_index == -1) {
+        state->page_faults++;
+
+        int replace_index = secondChanceVictim(state);
+        if (state->dirty[replace_index] == 1) {
+            state->writeBacks++;
+        }
+        if (state->frames[replace_index] != -1) {
+            STAT_ADD(state->stats, evictions, 1);
+            pageIndexRemove(&state->index, state->frames[replace_index]);
+        }
+
+        state->frames[replace_index] = page_number;
+        state->ref_registers[replace_index] = state->leftmost_bit;
+        state->dirty[replace_index] = dirty_bit;
+        pageIndexInsert(&state->index, page_number, replace_index);
+    } else {
+        //Set the leftmost bit of the register, the dirty bit follows the latest reference like in secondChance.c
+        state->ref_registers[page_index] |= state->leftmost_bit;
+        state->dirty[page_index] = dirty_bit;
+    }
+
+    //Shift the reference registers every aging_period references
+    if (++state->reference_count == state->aging_period) {
+        for (int j = 0; j < state->frame_count; j++) {
+            state->ref_registers[j] = (state->ref_registers[j] >> 1) & state->register_mask;
+        }
+        state->reference_count = 0;
+    }
+}
+
+// Function to simulate a chunk of references, one secondChanceStep each
+void secondChanceRun(SecondChanceState *state, const Page pages[], int count) {
+    STAT_RUN_BEGIN();
+    for (int i = 0; i < count; i++) {
+        secondChanceStep(state, pages[i]);
+    }
+    STAT_RUN_END(state->stats, count);
+}
+
+SimResult secondChanceFinish(SecondChanceState *state) {
+    pageIndexFree(&state->index);
+    free(state->frames);
+    free(state->ref_registers);
+    free(state->dirty);
+    SimResult result = {.frame_count = state->frame_count, .page_faults = state->page_faults, .writeBacks = state->writeBacks};
+    STAT_ATTACH(result, state->stats);
+    return result;
+}
+
+// ARC simulation state (Megiddo and Modha). T1 holds pages seen once recently and T2 pages seen at least
+// twice, B1 and B2 remember the pages last evicted from each, so a ghost hit tells which side deserved the
+// room and moves the target size p of T1. Resident and ghost entries share 2 * frame_count slots, each on
+// one of the four lists, and the page index maps a page to its slot.
+enum { ARC_T1, ARC_T2, ARC_B1, ARC_B2 };
+
+typedef struct {
+    int *pages;        //Page held by each slot
+    int *dirty;        //Dirty bit of each resident slot, ghosts are never dirty
+    int *list;         //ARC_T1, ARC_T2, ARC_B1 or ARC_B2 for each used slot
+    int *prev;         //List links towards the most recently used slot
+    int *next;         //List links towards the least recently used slot
+    int *free_slots;   //Stack of unused slots
+    int free_count;
+    FrameList lists[4]; //Head is the most recently used slot of each list
+    PageIndex index;   //Page number -> slot, residents and ghosts alike
+    int frame_count;
+    int target;        //p, the size T1 is steered towards
+    int page_faults;
+    int writeBacks;
+#ifdef PR_STATS
+    RunStats stats;
+#endif
+} ArcState;
+
+void arcInit(ArcState *state, int frame_count, int universe, bool compact) {
+    int slots = 2 * frame_count;
+    state->pages = checkedMalloc(slots * sizeof(int));
+    state->dirty = checkedMalloc(slots * sizeof(int));
+    state->list = checkedMalloc(slots * sizeof(int));
+    state->prev = checkedMalloc(slots * sizeof(int));
+    state->next = checkedMalloc(slots * sizeof(int));
+    state->free_slots = checkedMalloc(slots * sizeof(int));
+    for (int i = 0; i < slots; i++) {
+        state->free_slots[i] = slots - 1 - i; //Hand out slot 0 first
+    }
+    state->free_count = slots;
+    for (int l = 0; l < 4; l++) {
+        frameListInit(&state->lists[l]);
+    }
+    pageIndexInitPool(&state->index, slots, universe, compact);
+    state->frame_count = frame_count;
+    state->target = 0;
+    state->page_faults = 0;
+    state->writeBacks = 0;
+    STAT_ATTACH(*state, (RunStats){0});
+}
+
+// Function to move a slot to the most recently used end of another list
+static inline void arcMove(ArcState *state, int slot, int list) {
+    frameListUnlink(&state->lists[state->list[slot]], state->prev, state->next, slot);
+    frameListPushFront(&state->lists[list], state->prev, state->next, slot);
+    state->list[slot] = list;
+}
+
+// Function to drop the least recently used entry of a list, writing it back if it is a dirty resident page
+static inline void arcDiscard(ArcState *state, int list) {
+    int slot = state->lists[list].tail;
+    if (state->dirty[slot] == 1) {
+        state->writeBacks++;
+    }
+    frameListUnlink(&state->lists[list], state->prev, state->next, slot);
+    pageIndexRemove(&state->index, state->pages[slot]);
+    state->free_slots[state->free_count++] = slot;
+}
+
+// REPLACE: evict the least recently used page of T1 or T2 into its ghost list, whichever is over its share
+static inline void arcReplace(ArcState *state, bool in_b2) {
+    int t1_size = state->lists[ARC_T1].size;
+    int from = t1_size > 0 && (t1_size > state->target || (in_b2 && t1_size == state->target)) ? ARC_T1 : ARC_T2;
+    int slot = state->lists[from].tail;
+    STAT_ADD(state->stats, victim_search, 1);
+    STAT_ADD(state->stats, evictions, 1);
+    if (state->dirty[slot] == 1) {
+        state->writeBacks++;
+        state->dirty[slot] = 0;
+    }
+    arcMove(state, slot, from == ARC_T1 ? ARC_B1 : ARC_B2);
+}
+
+// ARC Page Replacement Algorithm
+// Every case is a hash lookup and a few list splices, so a reference costs O(1). Dirty bits follow LRU():
+// a hit can only set the bit, and a page is written back when it leaves memory dirty.
+static inline void arcStep(ArcState *state, Page reference) {
+    FrameList *lists = state->lists;
+    int c = state->frame_count;
+    int page = reference.page_number;
+    int dirty = reference.dirty;
+    int slot = pageIndexFind(&state->index, page);
+    int list = slot == -1 ? -1 : state->list[slot];
+
+    if (list == ARC_T1 || list == ARC_T2) {
+        //Hit, the page has now been seen twice
+        arcMove(state, slot, ARC_T2);
+        if (state->dirty[slot] == 0 && dirty == 1) {
+            state->dirty[slot] = 1;
+        }
+        return;
+    }
+
+    state->page_faults++;
+    if (list == ARC_B1 || list == ARC_B2) {
+        //Ghost hit, grow the side that would have kept the page
+        int b1_size = lists[ARC_B1].size;
+        int b2_size = lists[ARC_B2].size;
+        if (list == ARC_B1) {
+            int step = b2_size > b1_size ? b2_size / b1_size : 1;
+            state->target = state->target + step < c ? state->target + step : c;
+        } else {
+            int step = b1_size > b2_size ? b1_size / b2_size : 1;
+            state->target = state->target - step > 0 ? state->target - step : 0;
+        }
+        arcReplace(state, list == ARC_B2);
+        arcMove(state, slot, ARC_T2);
+        state->dirty[slot] = dirty;
+        return;
+    }
+
+    //A page ARC has not seen recently
+    int l1_size = lists[ARC_T1].size + lists[ARC_B1].size;
+    int total = l1_size + lists[ARC_T2].size + lists[ARC_B2].size;
+    if (l1_size == c) {
+        if (lists[ARC_T1].size < c) {
+            arcDiscard(state, ARC_B1);
+            arcReplace(state, false);
+        } else {
+            STAT_ADD(state->stats, victim_search, 1);
+            STAT_ADD(state->stats, evictions, 1);
+            arcDiscard(state, ARC_T1); //B1 is empty, so the page leaves without a ghost
+        }
+    } else if (total >= c) {
+        if (total == 2 * c) {
+            arcDiscard(state, ARC_B2);
+        }
+        arcReplace(state, false);
+    }
+
+    slot = state->free_slots[--state->free_count];
+    state->pages[slot] = page;
+    state->dirty[slot] = dirty;
+    state->list[slot] = ARC_T1;
+    frameListPushFront(&lists[ARC_T1], state->prev, state->next, slot);
+    pageIndexInsert(&state->index, page, slot);
+}
+
+// Function to simulate a chunk of references, one arcStep each
+void arcRun(ArcState *state, const Page pages[], int count) {
+    STAT_RUN_BEGIN();
+    for (int i = 0; i < count; i++) {
+        arcStep(state, pages[i]);
+    }
+    STAT_RUN_END(state->stats, count);
+}
+
+SimResult arcFinish(ArcState *state) {
+    pageIndexFree(&state->index);
+    free(state->pages);
+    free(state->dirty);
+    free(state->list);
+    free(state->prev);
+    free(state->next);
+    free(state->free_slots);
+    SimResult result = {.frame_count = state->frame_count, .page_faults = state->page_faults, .writeBacks = state->writeBacks};
+    STAT_ATTACH(result, state->stats);
+    return result;
+}
+
+// Count-min sketch of 4-bit counters estimating how often each page was referenced recently (TinyLFU)
+// Every page hashes to one 64-byte block of eight words and its four counters sit in four different words
+// of that block, so an increment or an estimate touches a single cache line. After sample_size increments
+// every counter is halved, so the estimates follow the recent past.
+typedef struct {
+    unsigned long long *table; // 16 counters per word, aligned to 64 bytes
+    int blockMask;             // Block count - 1, the block count is a power of two
+    int additions;             // Increments since the last halving
+    int sampleSize;
+} FrequencySketch;
+
+void sketchInit(FrequencySketch *sketch, int capacity) {
+    int blocks = 1;
+    while (blocks * 8 < capacity) {
+        blocks <<= 1; // About one word per page that fits in memory, like Caffeine
+    }
+    sketch->table = aligned_alloc(64, blocks * 64);
+    if (sketch->table == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(sketch->table, 0, blocks * 64);
+    sketch->blockMask = blocks - 1;
+    sketch->additions = 0;
+    sketch->sampleSize = 10 * capacity;
+}
+
+// Function to find the word and the shift of each of the four counters of a page
+static inline void sketchCounters(const FrequencySketch *sketch, int page, int words[4], int shifts[4]) {
+    unsigned int blockHash = (unsigned int)page * 0x9e3779b9u;
+    blockHash ^= blockHash >> 16;
+    unsigned int counterHash = blockHash * 0x31848babu;
+    counterHash ^= counterHash >> 14;
+    int block = (int)(blockHash & (unsigned int)sketch->blockMask) << 3;
+    for (int i = 0; i < 4; i++) {
+        unsigned int h = counterHash >> (i << 3);
+        words[i] = block + (i << 1) + (int)(h & 1); // Counter i lives in word 2i or 2i + 1 of the block
+        shifts[i] = (int)((h >> 1) & 15) << 2;
+    }
+}
+
+// Function to estimate how often a page was referenced, the lowest of its four counters
+static inline int sketchFrequency(const FrequencySketch *sketch, int page) {
+    int words[4], shifts[4];
+    sketchCounters(sketch, page, words, shifts);
+    int frequency = 15;
+    for (int i = 0; i < 4; i++) {
+        int counter = (int)(sketch->table[words[i]] >> shifts[i]) & 15;
+        frequency = counter < frequency ? counter : frequency;
+    }
+    return frequency;
+}
+
+// Function to count a reference, halving every counter once sampleSize references were counted
+static inline void sketchIncrement(FrequencySketch *sketch, int page) {
+    int words[4], shifts[4];
+    sketchCounters(sketch, page, words, shifts);
+    bool added = false;
+    for (int i = 0; i < 4; i++) {
+        if ((sketch->table[words[i]] >> shifts[i] & 15) != 15) {
+            sketch->table[words[i]] += 1ull << shifts[i];
+            added = true;
+        }
+    }
+    if (added && ++sketch->additions == sketch->sampleSize) {
+        for (int w = 0; w <= (sketch->blockMask << 3 | 7); w++) {
+            sketch->table[w] = (sketch->table[w] >> 1) & 0x7777777777777777ull;
+        }
+        sketch->additions /= 2;
+    }
+}
+
+void sketchFree(FrequencySketch *sketch) {
+    free(sketch->table);
+}
+
+// W-TinyLFU simulation state (Einziger, Friedman and Manes). New pages enter a window LRU of 1% of the
+// frames. A page leaving the window competes with the LRU victim of the main region, and only the one the
+// sketch says is referenced more often stays. The main region is a segmented LRU: pages start on probation
+// and a hit moves them to the protected segment (80% of the main region), whose LRU page drops back.
+enum { WTINYLFU_WINDOW, WTINYLFU_PROBATION, WTINYLFU_PROTECTED };
+
+typedef struct {
+    int *frames;       //Page held by each frame
+    int *dirty_bits;
+    int *region;       //WTINYLFU_WINDOW, WTINYLFU_PROBATION or WTINYLFU_PROTECTED for each used frame
+    int *prev;
+    int *next;
+    FrameList lists[3]; //Head is the most recently used frame of each region
+    PageIndex index;   //Page number -> frame holding it
+    FrequencySketch sketch;
+    const int *original; // Dense id -> original page number, so the sketch hashes the same keys in every mode
+    int frame_count;
+    int used_frames;
+    int window_capacity;
+    int protected_capacity;
+    int page_faults;
+    int writeBacks;
+#ifdef PR_STATS
+    RunStats stats;
+#endif
+} WTinyLfuState;
+
+void wTinyLfuInit(WTinyLfuState *state, int frame_count, int universe, bool compact, const int *original) {
+    state->frames = checkedMalloc(frame_count * sizeof(int));
+    state->dirty_bits = checkedMalloc(frame_count * sizeof(int));
+    state->region = checkedMalloc(frame_count * sizeof(int));
+    state->prev = checkedMalloc(frame_count * sizeof(int));
+    state->next = checkedMalloc(frame_count * sizeof(int));
+    for (int r = 0; r < 3; r++) {
+        frameListInit(&state->lists[r]);
+    }
+    pageIndexInitPool(&state->index, frame_count, universe, compact);
+    sketchInit(&state->sketch, frame_count);
+    state->original = original;
+    state->frame_count = frame_count;
+    state->used_frames = 0;
+    state->window_capacity = frame_count / 100 > 1 ? frame_count / 100 : 1;
+    state->protected_capacity = (frame_count - state->window_capacity) * 8 / 10;
+    state->page_faults = 0;
+    state->writeBacks = 0;
+    STAT_ATTACH(*state, (RunStats){0});
+}
+
+// Function to find the sketch key of a page, its number before any remapping
+static inline int wTinyLfuKey(const WTinyLfuState *state, int page) {
+    return state->original != NULL ? state->original[page] : page;
+}
+
+// Function to move a frame to the most recently used end of a region
+static inline void wTinyLfuMove(WTinyLfuState *state, int frame, int region) {
+    frameListUnlink(&state->lists[state->region[frame]], state->prev, state->next, frame);
+    frameListPushFront(&state->lists[region], state->prev, state->next, frame);
+    state->region[frame] = region;
+}
+
+// Function to evict the page in a frame, which is then free for the faulting page
+static inline void wTinyLfuEvict(WTinyLfuState *state, int frame) {
+    STAT_ADD(state->stats, evictions, 1);
+    if (state->dirty_bits[frame] == 1) {
+        state->writeBacks++;
+    }
+    frameListUnlink(&state->lists[state->region[frame]], state->prev, state->next, frame);
+    pageIndexRemove(&state->index, state->frames[frame]);
+}
+
+// W-TinyLFU Page Replacement Algorithm
+// Each reference is a hash lookup, one sketch update and a few list splices. Dirty bits follow LRU().
+static inline void wTinyLfuStep(WTinyLfuState *state, Page reference) {
+    FrameList *lists = state->lists;
+    int page = reference.page_number;
+    int dirty = reference.dirty;
+    int frame = pageIndexFind(&state->index, page);
+    sketchIncrement(&state->sketch, wTinyLfuKey(state, page));
+
+    if (frame != -1) {
+        if (state->region[frame] == WTINYLFU_PROBATION) {
+            //Reused while on probation, protect it and demote the protected LRU page if needed
+            wTinyLfuMove(state, frame, WTINYLFU_PROTECTED);
+            if (lists[WTINYLFU_PROTECTED].size > state->protected_capacity) {
+                wTinyLfuMove(state, lists[WTINYLFU_PROTECTED].tail, WTINYLFU_PROBATION);
+            }
+        } else {
+            wTinyLfuMove(state, frame, state->region[frame]);
+        }
+        if (state->dirty_bits[frame] == 0 && dirty == 1) {
+            state->dirty_bits[frame] = 1;
+        }
+        return;
+    }
+
+    state->page_faults++;
+    if (state->used_frames < state->frame_count) {
+        frame = state->used_frames++;
+        if (lists[WTINYLFU_WINDOW].size == state->window_capacity) {
+            //The main region still has room for the window's LRU page
+            wTinyLfuMove(state, lists[WTINYLFU_WINDOW].tail, WTINYLFU_PROBATION);
+        }
+    } else {
+        //The window's LRU page is the candidate, it stays only if it is more frequent than the main victim
+        int candidate = lists[WTINYLFU_WINDOW].tail;
+        int victim = lists[WTINYLFU_PROBATION].tail != -1 ? lists[WTINYLFU_PROBATION].tail : lists[WTINYLFU_PROTECTED].tail;
+        STAT_ADD(state->stats, victim_search, 2);
+        if (victim != -1 && sketchFrequency(&state->sketch, wTinyLfuKey(state, state->frames[candidate])) >
+                                sketchFrequency(&state->sketch, wTinyLfuKey(state, state->frames[victim]))) {
+            wTinyLfuMove(state, candidate, WTINYLFU_PROBATION);
+            frame = victim;
+        } else {
+            frame = candidate;
+        }
+        wTinyLfuEvict(state, frame);
+    }
+
+    state->frames[frame] = page;
+    state->dirty_bits[frame] = dirty;
+    state->region[frame] = WTINYLFU_WINDOW;
+    frameListPushFront(&lists[WTINYLFU_WINDOW], state->prev, state->next, frame);
+    pageIndexInsert(&state->index, page, frame);
+}
+
+// Function to simulate a chunk of references, one wTinyLfuStep each
+void wTinyLfuRun(WTinyLfuState *state, const Page pages[], int count) {
+    STAT_RUN_BEGIN();
+    for (int i = 0; i < count; i++) {
+        wTinyLfuStep(state, pages[i]);
+    }
+    STAT_RUN_END(state->stats, count);
+}
+
+SimResult wTinyLfuFinish(WTinyLfuState *state) {
+    pageIndexFree(&state->index);
+    sketchFree(&state->sketch);
+    free(state->frames);
+    free(state->dirty_bits);
+    free(state->region);
+    free(state->prev);
+    free(state->next);
+    SimResult result = {.frame_count = state->frame_count, .page_faults = state->page_faults, .writeBacks = state->writeBacks};
+    STAT_ATTACH(result, state->stats);
+    return result;
+}
+
+// A simulation of any streamable policy, fed with simulationRun
+typedef struct {
+    Policy policy;
+    union {
+        FifoState fifo;
+        LruState lru;
+        SecondChanceState sc;
+        ArcState arc;
+        WTinyLfuState wTinyLfu;
+    };
+} Simulation;
+
+void simulationInit(Simulation *sim, Policy policy, int frame_count, const SimOptions *options) {
+    sim->policy = policy;
+    if (policy == POLICY_FIFO) {
+        fifoInit(&sim->fifo, frame_count, options->universe, options->compact);
+    } else if (policy == POLICY_LRU) {
+        lruInit(&sim->lru, frame_count, options->universe, options->compact);
+    } else if (policy == POLICY_SC) {
+        secondChanceInit(&sim->sc, frame_count, options->aging_bits, options->aging_period, options->universe,
+                         options->compact);
+    } else if (policy == POLICY_ARC) {
+        arcInit(&sim->arc, frame_count, options->universe, options->compact);
+    } else {
+        wTinyLfuInit(&sim->wTinyLfu, frame_count, options->universe, options->compact, options->original);
+    }
+}
+
+void simulationRun(Simulation *sim, const Page pages[], int count) {
+    if (sim->policy == POLICY_FIFO) {
+        fifoRun(&sim->fifo, pages, count);
+    } else if (sim->policy == POLICY_LRU) {
+        lruRun(&sim->lru, pages, count);
+    } else if (sim->policy == POLICY_SC) {
+        secondChanceRun(&sim->sc, pages, count);
+    } else if (sim->policy == POLICY_ARC) {
+        arcRun(&sim->arc, pages, count);
+    } else {
+        wTinyLfuRun(&sim->wTinyLfu, pages, count);
+    }
+}
+
+// Function to simulate a single reference, for engines that interleave simulations reference by reference
+static inline void simulationStep(Simulation *sim, Page reference) {
+    if (sim->policy == POLICY_FIFO) {
+        fifoStep(&sim->fifo, reference);
+    } else if (sim->policy == POLICY_LRU) {
+        lruStep(&sim->lru, reference);
+    } else if (sim->policy == POLICY_SC) {
+        secondChanceStep(&sim->sc, reference);
+    } else if (sim->policy == POLICY_ARC) {
+        arcStep(&sim->arc, reference);
+    } else {
+        wTinyLfuStep(&sim->wTinyLfu, reference);
+    }
+}
+
+SimResult simulationFinish(Simulation *sim) {
+    if (sim->policy == POLICY_FIFO) {
+        return fifoFinish(&sim->fifo);
+    } else if (sim->policy == POLICY_LRU) {
+        return lruFinish(&sim->lru);
+    } else if (sim->policy == POLICY_SC) {
+        return secondChanceFinish(&sim->sc);
+    } else if (sim->policy == POLICY_ARC) {
+        return arcFinish(&sim->arc);
+    }
+    return wTinyLfuFinish(&sim->wTinyLfu);
+}
+
+// Function to look up a policy that runs as a Simulation by its command line name
+bool simulationPolicy(const char *name, Policy *policy) {
+    static const struct {
+        const char *name;
+        Policy policy;
+    } names[] = {{"FIFO", POLICY_FIFO}, {"LRU", POLICY_LRU}, {"SC", POLICY_SC}, {"ARC", POLICY_ARC},
+                 {"WTINYLFU", POLICY_WTINYLFU}};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i].name) == 0) {
+            *policy = names[i].policy;
             return true;
         }
     }
-    return false;
+    return false;
+}
+
+// Function to count the LRU faults and write-backs of every frame count 1..max_frames in a single pass
+// A reference with stack distance d hits in every pool of at least d frames. A page that is referenced
+// again at distance d was evicted in between from every pool smaller than d, and that eviction was a
+// write-back for pools of at least dirty_from frames, the smallest pool still holding its last dirty reference.
+// faults and writeBacks need max_frames + 2 zeroed entries, and hold the counts of c frames at index c.
+void lruStackCounts(const Page pages[], int count, int max_frames, long long faults[], long long writeBacks[]) {
+    //faults starts as a histogram of stack distances, writeBacks as a difference array
+    int *dirty_from = NULL; //Slot -> smallest pool in which the page's current copy is dirty
+    int slot_capacity = 0;
+    StackDistance sd;
+
+    stackDistanceInit(&sd);
+
+    for (int i = 0; i < count; i++) {
+        int slot;
+        int distance = stackDistanceAccess(&sd, pages[i].page_number, &slot);
+
+        if (slot == slot_capacity) {
+            slot_capacity = slot_capacity == 0 ? 1024 : 2 * slot_capacity;
+            dirty_from = realloc(dirty_from, slot_capacity * sizeof(int));
+            if (dirty_from == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (distance == 0) {
+            faults[max_frames + 1]++; //Cold miss for every pool
+            dirty_from[slot] = INT_MAX;
+        } else {
+            faults[distance <= max_frames ? distance : max_frames + 1]++;
+
+            //Pools in [dirty_from, distance - 1] evicted a dirty copy of this page since its last reference
+            int low = dirty_from[slot];
+            int high = distance - 1 < max_frames ? distance - 1 : max_frames;
+            if (low <= high) {
+                writeBacks[low]++;
+                writeBacks[high + 1]--;
+            }
+            if (distance > dirty_from[slot]) {
+                dirty_from[slot] = distance;
+            }
+        }
+        if (pages[i].dirty == 1) {
+            dirty_from[slot] = 1;
+        }
+    }
+
+    //Pages still resident at the end were evicted only from pools smaller than their final depth
+    for (int slot = 0; slot < sd.distinct; slot++) {
+        int depth = stackDistanceDepth(&sd, slot);
+        int low = dirty_from[slot];
+        int high = depth - 1 < max_frames ? depth - 1 : max_frames;
+        if (low <= high) {
+            writeBacks[low]++;
+            writeBacks[high + 1]--;
+        }
+    }
+
+    //A pool of c frames faults on every reference with distance greater than c
+    long long missing = faults[max_frames + 1];
+    for (int c = max_frames; c >= 1; c--) {
+        long long hits_at_c = faults[c];
+        faults[c] = missing;
+        missing += hits_at_c;
+    }
+    for (int c = 1; c <= max_frames; c++) {
+        writeBacks[c] += writeBacks[c - 1];
+    }
+
+    stackDistanceFree(&sd);
+    free(dirty_from);
+}
+
+// LRU for every frame count 1..max_frames in a single pass over the trace
+void LRUStack(Page pages[], int count, int max_frames) {
+    long long *faults = calloc(max_frames + 2, sizeof(long long));
+    long long *writeBacks = calloc(max_frames + 2, sizeof(long long));
+    if (faults == NULL || writeBacks == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    lruStackCounts(pages, count, max_frames, faults, writeBacks);
+    for (int c = 1; c <= max_frames; c++) {
+        printf("| %-6d | %-12lld | %-11lld |\n", c, faults[c], writeBacks[c]);
+        printf("+--------+--------------+-------------+\n");
+    }
+
+    free(faults);
+    free(writeBacks);
+}
+
+// SHARDS spatially hashed sampling (Waldspurger et al., FAST 2015). A reference is sampled when the hash of its
+// page is below a threshold T, so either every reference of a page is sampled or none is, and stack distances
+// among the sampled pages divided by the rate T / 2^24 estimate the distances in the whole trace.
+#define SHARDS_HASH_BITS 24
+
+static inline unsigned int shardsHash(int page) {
+    unsigned long long z = (unsigned int)page + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return (unsigned int)((z ^ (z >> 31)) >> (64 - SHARDS_HASH_BITS));
+}
+
+// A sampled page in the max-heap of the fixed-size variant, ordered by hash
+typedef struct {
+    unsigned int hash;
+    int page;
+} SampledPage;
+
+static void sampledHeapPush(SampledPage heap[], int *size, SampledPage item) {
+    int i = (*size)++;
+    while (i > 0 && heap[(i - 1) / 2].hash < item.hash) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = item;
+}
+
+static SampledPage sampledHeapPop(SampledPage heap[], int *size) {
+    SampledPage top = heap[0];
+    SampledPage last = heap[--(*size)];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= *size) {
+            break;
+        }
+        if (child + 1 < *size && heap[child + 1].hash > heap[child].hash) {
+            child++;
+        }
+        if (heap[child].hash <= last.hash) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (*size > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+// How an estimate was sampled
+typedef struct {
+    double rate;        // Final sampling rate
+    long long sampled;  // References sampled
+    int tracked;        // Pages tracked at the end, which bounds the memory used
+} ShardsSummary;
+
+// Function to estimate the LRU faults of frame counts 1..max_frames into faults[1..max_frames]
+// With max_samples 0 the rate stays fixed and memory grows with rate * distinct pages. Otherwise at most
+// max_samples pages are tracked: when one more would be, T drops to the largest tracked hash and the pages
+// with that hash are dropped, and the histogram is rescaled by the rate ratio as if the lower rate had been
+// used all along. Either way the histogram estimates misses at the final rate, so dividing by the rate (rather
+// than by the sampled references) gives the fault counts, which also corrects for sampling more or fewer
+// references than expected.
+ShardsSummary shardsEstimate(const Page pages[], int count, int max_frames, double rate, int max_samples,
+                             double faults[]) {
+    double *histogram = calloc(max_frames + 2, sizeof(double)); // Scaled stack distance -> sampled references
+    if (histogram == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    unsigned int threshold = (unsigned int)(rate * (1u << SHARDS_HASH_BITS) + 0.5);
+    SampledPage *heap = max_samples > 0 ? checkedMalloc((max_samples + 1) * sizeof(SampledPage)) : NULL;
+    int heap_size = 0;
+    ShardsSummary summary = {rate, 0, 0};
+    StackDistance sd;
+    stackDistanceInit(&sd);
+
+    for (int i = 0; i < count; i++) {
+        int page = pages[i].page_number;
+        unsigned int hash = shardsHash(page);
+        if (hash >= threshold) {
+            continue;
+        }
+        summary.sampled++;
+
+        int slot;
+        int distance = stackDistanceAccess(&sd, page, &slot);
+        if (distance == 0) {
+            histogram[max_frames + 1]++; // Cold miss for every pool
+            if (heap != NULL) {
+                sampledHeapPush(heap, &heap_size, (SampledPage){hash, page});
+            }
+        } else {
+            double scaled = distance / summary.rate; // Hits in every pool of at least ceil(scaled) frames
+            histogram[scaled <= max_frames ? (int)scaled + (scaled > (int)scaled) : max_frames + 1]++;
+        }
+
+        if (heap != NULL && heap_size > max_samples) {
+            unsigned int lowered = heap[0].hash;
+            while (heap_size > 0 && heap[0].hash == lowered) {
+                stackDistanceRemove(&sd, sampledHeapPop(heap, &heap_size).page);
+            }
+            double new_rate = (double)lowered / (1u << SHARDS_HASH_BITS);
+            for (int c = 1; c <= max_frames + 1; c++) {
+                histogram[c] *= new_rate / summary.rate;
+            }
+            threshold = lowered;
+            summary.rate = new_rate;
+        }
+    }
+
+    //A pool of c frames faults on every reference with scaled distance greater than c
+    double missing = histogram[max_frames + 1];
+    for (int c = max_frames; c >= 1; c--) {
+        faults[c] = summary.rate > 0 ? missing / summary.rate : 0;
+        missing += histogram[c];
+    }
+
+    summary.tracked = sd.distinct;
+    stackDistanceFree(&sd);
+    free(heap);
+    free(histogram);
+    return summary;
+}
+
+// Function to print the estimated LRU curve for frame counts 1..max_frames, and with verify its error against
+// the exact curve of lruStackCounts as a fraction of the references
+void shardsCurve(const Page pages[], int count, int max_frames, double rate, int max_samples, bool verify) {
+    double *faults = checkedMalloc((max_frames + 2) * sizeof(double));
+    ShardsSummary summary = shardsEstimate(pages, count, max_frames, rate, max_samples, faults);
+    printf("%s sampling, final rate %.6f, %lld of %d references sampled, %d pages tracked\n",
+           max_samples > 0 ? "Fixed-size" : "Fixed-rate", summary.rate, summary.sampled, count, summary.tracked);
+    if (summary.rate < 1) {
+        // One sampled page stands for 1 / rate pages, so smaller pools are only roughly resolved
+        printf("Pools of fewer than %.0f frames are below the sampling resolution\n", 1 / summary.rate);
+    }
+
+    long long *exact = NULL;
+    long long *writeBacks = NULL;
+    if (verify) {
+        exact = calloc(max_frames + 2, sizeof(long long));
+        writeBacks = calloc(max_frames + 2, sizeof(long long));
+        if (exact == NULL || writeBacks == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        lruStackCounts(pages, count, max_frames, exact, writeBacks);
+        printf("+--------+--------------+------------+--------------+------------+\n");
+        printf("| Frames | Est. Faults  | Miss Ratio | Exact Faults | Abs. Error |\n");
+        printf("+--------+--------------+------------+--------------+------------+\n");
+    } else {
+        printf("+--------+--------------+------------+\n");
+        printf("| Frames | Est. Faults  | Miss Ratio |\n");
+        printf("+--------+--------------+------------+\n");
+    }
+
+    double total_error = 0;
+    double max_error = 0;
+    for (int c = 1; c <= max_frames; c++) {
+        double ratio = count > 0 ? faults[c] / count : 0;
+        if (verify) {
+            double error = ratio - (count > 0 ? (double)exact[c] / count : 0);
+            error = error < 0 ? -error : error;
+            total_error += error;
+            max_error = error > max_error ? error : max_error;
+            printf("| %-6d | %-12.0f | %-10.6f | %-12lld | %-10.6f |\n", c, faults[c], ratio, exact[c], error);
+            printf("+--------+--------------+------------+--------------+------------+\n");
+        } else {
+            printf("| %-6d | %-12.0f | %-10.6f |\n", c, faults[c], ratio);
+            printf("+--------+--------------+------------+\n");
+        }
+    }
+    if (verify) {
+        printf("Miss ratio error: mean %.6f, max %.6f\n", total_error / max_frames, max_error);
+    }
+
+    free(faults);
+    free(exact);
+    free(writeBacks);
 }
 
-// Function to find the page that will not be used for the longest time
-int findOptimalPageToReplace(Page frames[], int frame_count, Page pages[], int current_page_index, int total_pages) {
-    int farthest = current_page_index;
-    int page_to_replace = -1;
+#ifdef PR_STATS
+// Every simulation printed by printResult, in table order, for the --stats report
+static SimResult *statRuns = NULL;
+static int statRunCount = 0;
 
-    for (int i = 0; i < frame_count; i++) {
-        int j;
-        for (j = current_page_index; j < total_pages; j++) {
-            if (frames[i].page_number == pages[j].page_number) {
-                // If the page is found in future references, break
-                if (j > farthest) {
-                    farthest = j;
-                    page_to_replace = i; // Update the page to replace
-                }
-                break;
-            }
+// Function to write the phase times and the counters of every simulation as JSON
+bool statsWrite(const char *path, const char *algorithm, int references, int universe) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        return false;
+    }
+    fprintf(out, "{\n  \"algorithm\": \"%s\",\n  \"references\": %d,\n  \"universe\": %d,\n", algorithm, references,
+            universe);
+    fprintf(out, "  \"phase_seconds\": {\"load\": %.6f, \"preprocess\": %.6f, \"simulate\": %.6f},\n",
+            statPhases.load, statPhases.preprocess, statPhases.simulate);
+    fprintf(out, "  \"runs\": [");
+    for (int i = 0; i < statRunCount; i++) {
+        const SimResult *run = &statRuns[i];
+        const RunStats *stats = &run->stats;
+        fprintf(out, "%s\n    {\"frames\": %d, \"references\": %lld, \"hits\": %lld, \"misses\": %d, "
+                     "\"cold_misses\": %lld, \"evictions\": %lld, \"dirty_evictions\": %d, \"clean_evictions\": %lld, "
+                     "\"lookups\": %lld, \"probes\": %lld, \"probes_per_lookup\": %.3f, \"victim_search\": %lld, "
+                     "\"victim_search_per_miss\": %.3f, \"cycles\": %llu, \"cycles_per_reference\": %.2f}",
+                i == 0 ? "" : ",", run->frame_count, stats->references, stats->references - run->page_faults,
+                run->page_faults, run->page_faults - stats->evictions, stats->evictions, run->writeBacks,
+                stats->evictions - run->writeBacks, stats->lookups, stats->probes,
+                stats->lookups > 0 ? (double)stats->probes / stats->lookups : 0.0, stats->victim_search,
+                run->page_faults > 0 ? (double)stats->victim_search / run->page_faults : 0.0, stats->cycles,
+                stats->references > 0 ? (double)stats->cycles / stats->references : 0.0);
+    }
+    fprintf(out, "\n  ]\n}\n");
+    return fclose(out) == 0;
+}
+#endif
+
+// Function to print one row of the results table
+void printResult(SimResult result) {
+    printf("| %-6d | %-12d | %-11d |\n", result.frame_count, result.page_faults, result.writeBacks);
+    printf("+--------+--------------+-------------+\n");
+#ifdef PR_STATS
+    statRuns = realloc(statRuns, (statRunCount + 1) * sizeof(SimResult));
+    if (statRuns == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    statRuns[statRunCount++] = result;
+#endif
+}
+
+// A frame-count sweep shared by the worker threads. The trace and next-use index are only read,
+// so the workers only coordinate on which frame count to simulate next.
+typedef struct {
+    Policy policy;
+    Page *pages;
+    int count;
+    const int *next_use;   // Only used by OPT
+    const SimOptions *options;
+    int max_frames;        // Frame counts 1..max_frames are simulated
+    SimResult *results;    // results[i] holds frame count i + 1
+    atomic_int next_frames; // Next frame count nobody has claimed yet
+} Sweep;
+
+// Worker loop: claim frame counts until the sweep is exhausted
+void *sweepWorker(void *arg) {
+    Sweep *sweep = arg;
+    for (;;) {
+        int frame_count = atomic_fetch_add(&sweep->next_frames, 1);
+        if (frame_count > sweep->max_frames) {
+            break;
         }
-        // If the page is never found, replace it immediately
-        if (j == total_pages) {
-            return i; // The frame is eligible for replacement
+
+        SimResult result;
+        if (sweep->policy == POLICY_OPT) {
+            result = Optimal(sweep->pages, sweep->count, frame_count, sweep->next_use);
+        } else {
+            Simulation sim;
+            simulationInit(&sim, sweep->policy, frame_count, sweep->options);
+            simulationRun(&sim, sweep->pages, sweep->count);
+            result = simulationFinish(&sim);
         }
+        sweep->results[frame_count - 1] = result;
     }
-    return page_to_replace; // Return the frame to replace
+    return NULL;
 }
 
-//Function to find if the page is in the frame
-int findPageIndex(int *frames, int frame_count, int page) {
-    for (int i = 0; i < frame_count; i++) {
-        if (frames[i] == page) {
-            return i;
+// Function to simulate frame counts 1..max_frames on thread_count threads and print the rows in frame order
+void runSweep(Policy policy, Page pages[], int count, int max_frames, const int *next_use, const SimOptions *options,
+              int thread_count) {
+    Sweep sweep;
+    sweep.policy = policy;
+    sweep.pages = pages;
+    sweep.count = count;
+    sweep.next_use = next_use;
+    sweep.options = options;
+    sweep.max_frames = max_frames;
+    sweep.results = checkedMalloc(max_frames * sizeof(SimResult));
+    atomic_init(&sweep.next_frames, 1);
+
+    if (thread_count > max_frames) {
+        thread_count = max_frames;
+    }
+
+    // The calling thread is one of the workers
+    pthread_t *workers = checkedMalloc(thread_count * sizeof(pthread_t));
+    int started = 0;
+    for (int t = 1; t < thread_count; t++) {
+        if (pthread_create(&workers[started], NULL, sweepWorker, &sweep) != 0) {
+            break; // Carry on with the threads we have
         }
+        started++;
     }
-    return -1;
+    sweepWorker(&sweep);
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    for (int i = 0; i < max_frames; i++) {
+        printResult(sweep.results[i]);
+    }
+
+    free(workers);
+    free(sweep.results);
 }
 
-//Function to find the least recently used page index
-int findLRUIndex(int *access_time, int frame_count) {
-    int lru_index = 0;
-    for (int i = 1; i < frame_count; i++) {
-        if (access_time[i] < access_time[lru_index]) {
-            lru_index = i;
+// Fused sweep: many simulations advanced together over one traversal of the trace
+// The trace is walked in blocks, and a thread advances its simulations over each block FUSED_GROUP at a time,
+// reference by reference. A block is read from memory once per thread instead of once per simulation and stays
+// in the last-level cache while every group walks it, and the simulations of a group are independent, so the
+// out-of-order core overlaps their misses and list updates instead of waiting on one dependency chain. The
+// simulations use the compact index, 16-bit frame slots behind the residency bitset, so the state of a group
+// stays in the L2 cache over a block. Blocks are large because each group reloads its state once per block.
+// That covers the whole frame sweep of FIFO, which has no stack property, and of several policies at once.
+#define FUSED_BLOCK_RECORDS (1 << 21) // 16 MiB of records
+#define FUSED_GROUP 2
+#define MAX_FUSED_POLICIES 8
+
+// A thread of the fused sweep, running simulations first, first + step, ...
+typedef struct {
+    Simulation *sims;
+    int sim_count;
+    int first;
+    int step;
+    const Page *pages;
+    int count;
+} FusedWorker;
+
+void *fusedWorker(void *arg) {
+    FusedWorker *worker = arg;
+    for (int start = 0; start < worker->count; start += FUSED_BLOCK_RECORDS) {
+        int length = worker->count - start < FUSED_BLOCK_RECORDS ? worker->count - start : FUSED_BLOCK_RECORDS;
+        const Page *block = worker->pages + start;
+#ifdef PR_STATS
+        // Stats builds run one simulation at a time so each keeps its own cycle count
+        for (int i = worker->first; i < worker->sim_count; i += worker->step) {
+            simulationRun(&worker->sims[i], block, length);
         }
+#else
+        for (int i = worker->first; i < worker->sim_count;) {
+            Simulation *group[FUSED_GROUP];
+            int size = 0;
+            for (; size < FUSED_GROUP && i < worker->sim_count; i += worker->step) {
+                group[size++] = &worker->sims[i];
+            }
+            for (int r = 0; r < length; r++) {
+                for (int k = 0; k < size; k++) {
+                    simulationStep(group[k], block[r]);
+                }
+            }
+        }
+#endif
     }
-    return lru_index;
+    return NULL;
 }
 
-// FIFO Page Replacement Algorithm
-// signature contains: a list of pages read from the input file, counter that counts the number of pages, frame count for number of frames available 
-void FIFO(Page pages[], int count, int frame_count) {
-    Page frames[frame_count];       // creates array of frames with size of frame_count 
-    int frame_index = 0;  // Index for the FIFO replacement
-    int page_faults = 0;  // Count of page faults
-    int writeBacks = 0;
+// Function to simulate frame counts 1..max_frames of every policy in one fused pass on thread_count threads
+// Each policy gets its own table, headed by its name when there are several.
+void fusedSweep(const Policy policies[], char *const names[], int policy_count, const Page pages[], int count,
+                int max_frames, const SimOptions *options, int thread_count) {
+    int sim_count = policy_count * max_frames;
+    Simulation *sims = checkedMalloc(sim_count * sizeof(Simulation));
+    SimOptions compact = *options;
+    compact.compact = true;
+    for (int p = 0; p < policy_count; p++) {
+        for (int f = 0; f < max_frames; f++) {
+            simulationInit(&sims[p * max_frames + f], policies[p], f + 1, &compact);
+        }
+    }
 
-    Page emptyPage;
-    emptyPage.page_number = -1;
-    emptyPage.dirty = 0;
+    if (thread_count > sim_count) {
+        thread_count = sim_count;
+    }
+    FusedWorker *workers = checkedMalloc(thread_count * sizeof(FusedWorker));
+    pthread_t *threads = checkedMalloc(thread_count * sizeof(pthread_t));
+    bool *started = calloc(thread_count, sizeof(bool));
+    if (started == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < thread_count; t++) {
+        workers[t] = (FusedWorker){sims, sim_count, t, thread_count, pages, count};
+    }
 
-    // Initialize frames
-    for (int i = 0; i < frame_count; i++) {
-        frames[i] = emptyPage; // fill the frame with empty pages
+    // The calling thread is worker 0, and also runs the share of any thread that could not be started
+    for (int t = 1; t < thread_count; t++) {
+        started[t] = pthread_create(&threads[t], NULL, fusedWorker, &workers[t]) == 0;
+    }
+    fusedWorker(&workers[0]);
+    for (int t = 1; t < thread_count; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            fusedWorker(&workers[t]);
+        }
     }
 
-    for (int i = 0; i < count; i++) {
-        Page current_page = pages[i];
+    for (int p = 0; p < policy_count; p++) {
+        if (policy_count > 1) {
+            printf("%s\n", names[p]);
+        }
+        printf("+--------+--------------+-------------+\n");
+        printf("| Frames | Page Faults  | Write backs |\n");
+        printf("+--------+--------------+-------------+\n");
+        for (int f = 0; f < max_frames; f++) {
+            printResult(simulationFinish(&sims[p * max_frames + f]));
+        }
+    }
 
-        // Check if the current page is already in the frames
-        if (!isPagePresent(frames, frame_count, current_page)) {
-            // Page fault occurs
-            page_faults++;
+    free(sims);
+    free(workers);
+    free(threads);
+    free(started);
+}
 
-            // if a dirty page is evicted from memory, add one to writeBacks
-            if(frames[frame_index].page_number != -1 && frames[frame_index].dirty == 1){
-                writeBacks++;       
+// Set by SIGINT so a streaming run over a live capture stops reading and reports what it has seen
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int signal_number) {
+    (void)signal_number;
+    stopRequested = 1;
+}
+
+// Ring of parsed chunks broadcast from the reader to every simulator thread of a pipelined stream
+// Chunk n lives in slot n % PIPELINE_SLOTS. The reader publishes it by advancing published and may only refill
+// a slot once every consumer has moved past it, so the only shared state is a handful of counters and no
+// locks are taken. Each counter sits on its own cache line so the threads do not invalidate each other.
+#define PIPELINE_SLOTS 8
+
+typedef struct {
+    _Alignas(64) atomic_llong value;
+} PaddedCounter;
+
+typedef struct {
+    Trace slots[PIPELINE_SLOTS];
+    PaddedCounter published; // Chunks published so far
+    PaddedCounter finished;  // Set once published is final
+    PaddedCounter *consumed; // Chunks each consumer has finished with
+    int consumer_count;
+} ChunkRing;
+
+// A simulator thread of a pipelined stream, running frame counts first + 1, first + 1 + step, ...
+typedef struct {
+    ChunkRing *ring;
+    Simulation *sims;
+    int first;
+    int step;
+    int max_frames;
+} PipelineWorker;
+
+// Function to back off while another thread catches up
+static inline void pipelineWait(void) {
+    sched_yield();
+}
+
+// Consumer loop: simulate every published chunk on this thread's frame counts until the reader finishes
+void *pipelineWorker(void *arg) {
+    PipelineWorker *worker = arg;
+    ChunkRing *ring = worker->ring;
+    for (long long n = 0;; n++) {
+        while (atomic_load_explicit(&ring->published.value, memory_order_acquire) <= n) {
+            if (atomic_load_explicit(&ring->finished.value, memory_order_acquire) &&
+                atomic_load_explicit(&ring->published.value, memory_order_acquire) <= n) {
+                return NULL;
             }
+            pipelineWait();
+        }
+        const Trace *chunk = &ring->slots[n % PIPELINE_SLOTS];
+        for (int i = worker->first; i < worker->max_frames; i += worker->step) {
+            simulationRun(&worker->sims[i], chunk->pages, chunk->count);
+        }
+        atomic_store_explicit(&ring->consumed[worker->first].value, n + 1, memory_order_release);
+    }
+}
 
-            // Replace the page using FIFO method
-            frames[frame_index] = current_page;
-            frame_index = (frame_index + 1) % frame_count; // Move to the next frame in a circular manner
+// Function to wait until every consumer is done with the slot that chunk n will reuse
+static void ringWaitForSlot(ChunkRing *ring, long long n) {
+    for (int c = 0; c < ring->consumer_count; c++) {
+        while (atomic_load_explicit(&ring->consumed[c].value, memory_order_acquire) <= n - PIPELINE_SLOTS) {
+            pipelineWait();
+        }
+    }
+}
 
-        } else {
+// Function to simulate frame counts 1..max_frames while the trace is being read
+// Each chunk of records is fed to every simulation and then dropped, so memory depends on the frame counts
+// and the chunk size, not on the trace length. Reading stops at end of input or on SIGINT.
+// With more than one thread the calling thread only reads and parses, and thread_count simulator threads
+// split the frame counts between them and run each chunk as soon as it is published, so reading and parsing
+// overlap with simulating.
+int streamSweep(int fd, Policy policy, int max_frames, const SimOptions *options, int thread_count) {
+    Simulation *sims = checkedMalloc(max_frames * sizeof(Simulation));
+    Trace single = {NULL, NULL, 0, 0}; // Records of the current chunk when not pipelined, reused for every chunk
+    size_t buffer_size = 1 << 20;
+    size_t filled = 0;
+    char *buffer = checkedMalloc(buffer_size);
 
-            // if the page is present, but the dirty bit is different
-            for (int j = 0; j < frame_count; j++) {
-                if(frames[j].page_number == current_page.page_number){
-                    if (frames[j].dirty == 0 && current_page.dirty ==1)    
-                        frames[j].dirty = 1;
-                        //writeBacks++;
-                }
+    for (int i = 0; i < max_frames; i++) {
+        simulationInit(&sims[i], policy, i + 1, options);
+    }
 
-            
+    if (thread_count > max_frames) {
+        thread_count = max_frames;
+    }
+    bool pipelined = thread_count > 1;
+    ChunkRing ring;
+    PipelineWorker *workers = NULL;
+    pthread_t *threads = NULL;
+    int started = 0;
+    if (pipelined) {
+        for (int s = 0; s < PIPELINE_SLOTS; s++) {
+            ring.slots[s] = (Trace){NULL, NULL, 0, 0};
+        }
+        atomic_init(&ring.published.value, 0);
+        atomic_init(&ring.finished.value, 0);
+        ring.consumed = aligned_alloc(64, thread_count * sizeof(PaddedCounter));
+        workers = checkedMalloc(thread_count * sizeof(PipelineWorker));
+        threads = checkedMalloc(thread_count * sizeof(pthread_t));
+        if (ring.consumed == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int t = 0; t < thread_count; t++) {
+            atomic_init(&ring.consumed[t].value, 0);
+            workers[t] = (PipelineWorker){&ring, sims, t, thread_count, max_frames};
+        }
+        ring.consumer_count = thread_count;
+        for (int t = 0; t < thread_count; t++) {
+            if (pthread_create(&threads[t], NULL, pipelineWorker, &workers[t]) != 0) {
+                break;
+            }
+            started++;
+        }
+        if (started < thread_count) {
+            // Nothing is published yet, so the threads that did start stop at once and this thread simulates
+            atomic_store_explicit(&ring.finished.value, 1, memory_order_release);
+            for (int t = 0; t < started; t++) {
+                pthread_join(threads[t], NULL);
+            }
+            started = 0;
+            pipelined = false;
+        }
+    }
+
+    // No SA_RESTART, so a pending read returns EINTR when the user interrupts
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+
+    bool at_end = false;
+    for (long long n = 0; !at_end; n++) {
+        if (filled == buffer_size) {
+            buffer_size *= 2; // A single line is longer than the buffer
+            buffer = realloc(buffer, buffer_size);
+            if (buffer == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed\n");
+                exit(EXIT_FAILURE);
             }
+        }
+
+        ssize_t got = stopRequested ? 0 : read(fd, buffer + filled, buffer_size - filled);
+        if (got < 0 && errno == EINTR && !stopRequested) {
+            n--;
+            continue;
+        }
+        at_end = got <= 0;
+        if (!at_end && filled < TRACE_HEADER_SIZE && filled + got >= TRACE_HEADER_SIZE &&
+            isBinaryTrace((unsigned char *)buffer, filled + got)) {
+            fprintf(stderr, "Error: --stream reads CSV traces, load binary traces without it.\n");
+            exit(EXIT_FAILURE);
+        }
+        filled += at_end ? 0 : got;
 
+        Trace *chunk = &single;
+        if (pipelined) {
+            ringWaitForSlot(&ring, n);
+            chunk = &ring.slots[n % PIPELINE_SLOTS];
+        }
+        chunk->count = 0;
+        size_t consumed = parseTraceChunk(buffer, filled, at_end, chunk);
+        memmove(buffer, buffer + consumed, filled - consumed);
+        filled -= consumed;
 
+        if (pipelined) {
+            atomic_store_explicit(&ring.published.value, n + 1, memory_order_release);
+        } else {
+            for (int i = 0; i < max_frames; i++) {
+                simulationRun(&sims[i], chunk->pages, chunk->count);
+            }
         }
     }
 
-    // Print results for this iteration
-    printf("| %-6d | %-12d | %-11d |\n",frame_count,page_faults,writeBacks);    // Write backs not implemented yet.
+    if (pipelined) {
+        atomic_store_explicit(&ring.finished.value, 1, memory_order_release);
+        for (int t = 0; t < started; t++) {
+            pthread_join(threads[t], NULL);
+        }
+    }
+    if (thread_count > 1) {
+        for (int s = 0; s < PIPELINE_SLOTS; s++) {
+            free(ring.slots[s].pages);
+            free(ring.slots[s].pids);
+        }
+        free(ring.consumed);
+    }
+    for (int i = 0; i < max_frames; i++) {
+        printResult(simulationFinish(&sims[i]));
+    }
 
-    
-    // print the last line
-    printf("+--------+--------------+-------------+\n");
-       
-    
-    //free(frames); // Free the frame memory
+    free(sims);
+    free(workers);
+    free(threads);
+    free(single.pages);
+    free(single.pids);
+    free(buffer);
+    return EXIT_SUCCESS;
 }
 
+// Parameters swept by the variable-allocation policies WS and PFF
+#define MAX_SWEEP_VALUES 64
+typedef struct {
+    int taus[MAX_SWEEP_VALUES];  // Working-set windows, in references
+    int tau_count;
+    int lows[MAX_SWEEP_VALUES];  // PFF inter-fault intervals below which the resident set grows
+    int highs[MAX_SWEEP_VALUES]; // PFF inter-fault intervals above which it shrinks
+    int threshold_count;
+} VariableOptions;
 
-// Optimal Page Replacement Algorithm
-void Optimal(Page pages[], int count, int frame_count) {
-    Page frames[frame_count];       // Array of frames with size of frame_count 
-    int page_faults = 0;  // Count of page faults
-    int writeBacks = 0;
-    
-    // Initialize frames
-    for (int i = 0; i < frame_count; i++) {
-        frames[i].page_number = -1; // fill the frame with empty pages
-        frames[i].dirty = 0; // fill the frame with empty pages
+// Result of one run of a variable-allocation policy
+typedef struct {
+    int low;                 // Window for WS, lower inter-fault threshold for PFF
+    int high;                // Upper inter-fault threshold for PFF, unused by WS
+    int page_faults;
+    int writeBacks;
+    double average_resident; // Resident set size averaged over the references
+    int peak_resident;
+} VariableResult;
+
+// Resident pages of a variable-allocation policy in order of last reference, the least recent at the tail
+// Both policies only ever drop pages referenced before some time, which are always a suffix of this list, so
+// trimming costs O(1) per page dropped and every page is dropped at most once per load.
+typedef struct {
+    FrameList recency;
+    int *prev;
+    int *next;
+    int *last_use;           // Time of the last reference of each resident page
+    unsigned char *resident;
+    unsigned char *dirty;
+} ResidentSet;
+
+void residentSetInit(ResidentSet *set, int universe) {
+    frameListInit(&set->recency);
+    set->prev = checkedMalloc(universe * sizeof(int));
+    set->next = checkedMalloc(universe * sizeof(int));
+    set->last_use = checkedMalloc(universe * sizeof(int));
+    set->resident = calloc(universe, 1);
+    set->dirty = calloc(universe, 1);
+    if (set->resident == NULL || set->dirty == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
     }
+}
 
-    for (int i = 0; i < count; i++) {
-        Page current_page = pages[i];
+void residentSetFree(ResidentSet *set) {
+    free(set->prev);
+    free(set->next);
+    free(set->last_use);
+    free(set->resident);
+    free(set->dirty);
+}
 
-        // Check if the current page is already in the frames
-        if (!isPagePresent(frames, frame_count, current_page)) {
-            // Page fault occurs
-            page_faults++;
+// Function to make page the most recently used one at time now, loading it if it is not resident
+static inline void residentSetTouch(ResidentSet *set, Page page, int now) {
+    int id = page.page_number;
+    if (set->resident[id]) {
+        frameListUnlink(&set->recency, set->prev, set->next, id);
+        set->dirty[id] |= page.dirty == 1;
+    } else {
+        set->resident[id] = 1;
+        set->dirty[id] = page.dirty == 1;
+    }
+    frameListPushFront(&set->recency, set->prev, set->next, id);
+    set->last_use[id] = now;
+}
 
-            // Determine which page to replace using optimal algorithm
-            int page_to_replace = findOptimalPageToReplace(frames, frame_count, pages, i, count);
-            
-            // Check if there is a need to write back a dirty page
-            if (page_to_replace != -1 && frames[page_to_replace].dirty == 1) {
-                writeBacks++;
-            }
+// Function to drop the least recently used page, counting a write-back if it is dirty
+static inline void residentSetEvict(ResidentSet *set, VariableResult *result) {
+    int victim = set->recency.tail;
+    frameListUnlink(&set->recency, set->prev, set->next, victim);
+    set->resident[victim] = 0;
+    result->writeBacks += set->dirty[victim];
+}
 
-            // Replace the page in the frame
-            frames[page_to_replace] = current_page;
-        }  else {
+// Function to drop every page not referenced since time before
+static inline void residentSetTrim(ResidentSet *set, int before, VariableResult *result) {
+    while (set->recency.tail != -1 && set->last_use[set->recency.tail] < before) {
+        residentSetEvict(set, result);
+    }
+}
 
-            // if the page is present, but the dirty bit is different
-            for (int j = 0; j < frame_count; j++) {
-                if(frames[j].page_number == current_page.page_number){
-                    if (frames[j].dirty == 0 && current_page.dirty ==1)    
-                        frames[j].dirty = 1;
-                        //writeBacks++;
-                }
+// Working set with window tau: after each reference the resident set is exactly the pages referenced in the
+// last tau references, so it grows and shrinks with the program's locality
+VariableResult workingSet(const Page pages[], int count, int universe, int tau) {
+    VariableResult result = {.low = tau};
+    ResidentSet set;
+    residentSetInit(&set, universe);
+    long long resident_sum = 0;
 
-            
+    for (int i = 0; i < count; i++) {
+        result.page_faults += !set.resident[pages[i].page_number];
+        residentSetTouch(&set, pages[i], i);
+        residentSetTrim(&set, i - tau + 1, &result);
+
+        resident_sum += set.recency.size;
+        if (set.recency.size > result.peak_resident) {
+            result.peak_resident = set.recency.size;
+        }
+    }
+
+    result.average_resident = count > 0 ? (double)resident_sum / count : 0;
+    residentSetFree(&set);
+    return result;
+}
+
+// Page-fault frequency with two thresholds on the time between faults, measured at each fault
+// Faulting again within low references means the fault rate is above its upper bound, so the page is added
+// and the resident set grows. After more than high references the rate is below its lower bound, so every
+// page not referenced since the previous fault is dropped first. In between the set keeps its size and the
+// least recently used page makes room.
+VariableResult pageFaultFrequency(const Page pages[], int count, int universe, int low, int high) {
+    VariableResult result = {.low = low, .high = high};
+    ResidentSet set;
+    residentSetInit(&set, universe);
+    long long resident_sum = 0;
+    int last_fault = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (!set.resident[pages[i].page_number]) {
+            result.page_faults++;
+            int interval = i - last_fault;
+            if (interval > high) {
+                residentSetTrim(&set, last_fault, &result);
+            } else if (interval >= low && set.recency.size > 0) {
+                residentSetEvict(&set, &result);
             }
+            last_fault = i;
         }
+        residentSetTouch(&set, pages[i], i);
 
+        resident_sum += set.recency.size;
+        if (set.recency.size > result.peak_resident) {
+            result.peak_resident = set.recency.size;
+        }
     }
 
-    // Print results for this iteration
-    printf("| %-6d | %-12d | %-11d |\n", frame_count, page_faults, writeBacks);
-    
-    // print the last line
-    printf("+--------+--------------+-------------+\n");
+    result.average_resident = count > 0 ? (double)resident_sum / count : 0;
+    residentSetFree(&set);
+    return result;
 }
 
-void LRU(Page pages[], int count, int frame_count) {
-    int *frames = (int *)malloc(frame_count * sizeof(int)); //Array for the frames
-    int *access_time = (int *)malloc(frame_count * sizeof(int)); //Array to track access time
-    int *dirty_bits = (int *)malloc(frame_count * sizeof(int)); //Array to track the dirty bits for frames
-    int page_faults = 0;  //number of page faults
-    int writeBacks = 0;
-    int current_time = 0; //tracking the access order
+// A window or threshold sweep of WS or PFF shared by the worker threads, like the frame-count sweep
+typedef struct {
+    bool pff;
+    const Page *pages;
+    int count;
+    int universe;
+    const VariableOptions *options;
+    int runs;                // Windows for WS, threshold pairs for PFF
+    VariableResult *results; // results[i] holds run i
+    atomic_int next_run;     // Next run nobody has claimed yet
+} VariableSweep;
 
-    //Initialize frames, access times, and dirty bits
-    for (int i = 0; i < frame_count; i++) {
-        frames[i] = -1; //Empty frame
-        access_time[i] = -1; //set frame as never been accessed
-        dirty_bits[i] = 0; //Initialize the dirty bits
+// Worker loop: claim runs until the sweep is exhausted
+void *variableSweepWorker(void *arg) {
+    VariableSweep *sweep = arg;
+    const VariableOptions *options = sweep->options;
+    for (;;) {
+        int run = atomic_fetch_add(&sweep->next_run, 1);
+        if (run >= sweep->runs) {
+            break;
+        }
+        if (sweep->pff) {
+            sweep->results[run] = pageFaultFrequency(sweep->pages, sweep->count, sweep->universe, options->lows[run],
+                                                     options->highs[run]);
+        } else {
+            sweep->results[run] = workingSet(sweep->pages, sweep->count, sweep->universe, options->taus[run]);
+        }
     }
+    return NULL;
+}
 
-    for (int i = 0; i < count; i++) {  //Iterate through all of the pages
-        int current_page = pages[i].page_number; //Get the current page number from the list of pages
-        int current_dirty = pages[i].dirty; //Get the current page dirty status
-        int page_index = findPageIndex(frames, frame_count, current_page); //Current page in the frame
+// Function to run WS for every window, or PFF for every threshold pair, on thread_count threads and print a row each
+void variableSweep(bool pff, const Page pages[], int count, int universe, const VariableOptions *options,
+                   int thread_count) {
+    VariableSweep sweep;
+    sweep.pff = pff;
+    sweep.pages = pages;
+    sweep.count = count;
+    sweep.universe = universe;
+    sweep.options = options;
+    sweep.runs = pff ? options->threshold_count : options->tau_count;
+    sweep.results = checkedMalloc(sweep.runs * sizeof(VariableResult));
+    atomic_init(&sweep.next_run, 0);
 
-        if (page_index == -1) { //Page fault occurs
-            page_faults++;
+    if (thread_count > sweep.runs) {
+        thread_count = sweep.runs;
+    }
 
-            //Find the least recently used page index
-            int lru_index = findLRUIndex(access_time, frame_count);
+    // The calling thread is one of the workers
+    pthread_t *workers = checkedMalloc(thread_count * sizeof(pthread_t));
+    int started = 0;
+    for (int t = 1; t < thread_count; t++) {
+        if (pthread_create(&workers[started], NULL, variableSweepWorker, &sweep) != 0) {
+            break; // Carry on with the threads we have
+        }
+        started++;
+    }
+    variableSweepWorker(&sweep);
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
 
-            //Check and replace if a different page is being loaded into the frame
-            if (frames[lru_index] != current_page) {
-                //Check if the frame to be replaced is dirty
-                if (frames[lru_index] != -1 && dirty_bits[lru_index] == 1) {
-                    writeBacks++;
-                }
-                
-                                                                                                                                                                                                    //Replace the page with the current page
-                frames[lru_index] = current_page;
-                access_time[lru_index] = current_time; //Update the access time for the new page
-                dirty_bits[lru_index] = current_dirty; //Set the dirty bit for the new page
-            }
+    printf("+-------------+--------------+-------------+-----------+----------+\n");
+    printf("| %-11s | Page Faults  | Write backs | Avg RSS   | Peak RSS |\n", pff ? "Low,High" : "Window");
+    printf("+-------------+--------------+-------------+-----------+----------+\n");
+    for (int run = 0; run < sweep.runs; run++) {
+        const VariableResult *result = &sweep.results[run];
+        char parameter[32];
+        if (pff) {
+            snprintf(parameter, sizeof(parameter), "%d,%d", result->low, result->high);
         } else {
-            access_time[page_index] = current_time; //Update access time
+            snprintf(parameter, sizeof(parameter), "%d", result->low);
+        }
+        printf("| %-11s | %-12d | %-11d | %-9.1f | %-8d |\n", parameter, result->page_faults, result->writeBacks,
+               result->average_resident, result->peak_resident);
+        printf("+-------------+--------------+-------------+-----------+----------+\n");
+    }
+
+    free(workers);
+    free(sweep.results);
+}
+
+// Options of the multi-process simulation (MULTI)
+typedef struct {
+    int frames;    // Frames in the pool the processes share
+    bool local;    // Each process replaces only its own pages, otherwise any page in the pool can be replaced
+    bool pff;      // Local allocations follow each process's page-fault frequency instead of staying fixed
+    int pff_low;   // A process faulting again within this many of its own references gains a frame
+    int pff_high;  // A process going more than this many of its own references without a fault gives one back
+} PoolOptions;
+
+// Counts and allocation of one process in the multi-process simulation
+typedef struct {
+    long long references;
+    long long page_faults;
+    long long writeBacks;
+    long long last_fault; // Value of references at the process's previous fault
+    int allocation;       // Frames the process may hold under local replacement
+    int resident;         // Frames it holds
+    FrameList lru;        // Its resident pages, most recently used first (local replacement only)
+} ProcessState;
+
+// Function to simulate processes sharing one pool of frames, with LRU replacement within the pool
+// Pages are dense ids, owner gives the process of each page id and pids the process of each reference (NULL
+// when every reference belongs to process 0). Global replacement evicts the least recently used page of any
+// process. Local replacement evicts the process's own least recently used page once it holds its allocation,
+// which starts proportional to its number of distinct pages. With pff set a process that faults within
+// pff_low of its own references takes a frame from the unallocated ones, and one going longer than pff_high
+// gives one back, so no step ever looks at the other processes and each reference costs O(1).
+// Returns false if local replacement cannot give every process a frame.
+bool multiProcessRun(const Page pages[], const int pids[], int count, const int owner[], int universe,
+                     ProcessState processes[], int process_count, const PoolOptions *pool) {
+    for (int p = 0; p < process_count; p++) {
+        processes[p] = (ProcessState){0};
+        frameListInit(&processes[p].lru);
+    }
+
+    if (pool->local) {
+        if (pool->frames < process_count) {
+            return false;
+        }
+        // Every process gets one frame, the rest are split by size with cumulative rounding so they add up
+        long long spare = pool->frames - process_count;
+        long long total = universe > 0 ? universe : 1;
+        long long before = 0;
+        for (int page = 0; page < universe; page++) {
+            processes[owner != NULL ? owner[page] : 0].allocation++; // Distinct pages for now
+        }
+        for (int p = 0; p < process_count; p++) {
+            long long size = processes[p].allocation;
+            processes[p].allocation = 1 + (int)(spare * (before + size) / total - spare * before / total);
+            before += size;
+        }
+    }
+
+    int *prev = checkedMalloc(universe * sizeof(int));
+    int *next = checkedMalloc(universe * sizeof(int));
+    unsigned char *resident = calloc(universe, 1);
+    unsigned char *dirty = calloc(universe, 1);
+    if (resident == NULL || dirty == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    FrameList global; // Every resident page, most recently used first (global replacement only)
+    frameListInit(&global);
+    int unallocated = 0; // Frames given back under pff and not yet taken by another process
+
+    for (int i = 0; i < count; i++) {
+        int page = pages[i].page_number;
+        ProcessState *process = &processes[pids != NULL ? pids[i] : 0];
+        FrameList *list = pool->local ? &process->lru : &global;
+        process->references++;
+
+        if (resident[page]) {
+            frameListUnlink(list, prev, next, page);
+            frameListPushFront(list, prev, next, page);
+            dirty[page] |= pages[i].dirty == 1;
+            continue;
+        }
 
-            //Update the dirty bit 
-            if (dirty_bits[page_index] == 0 && current_dirty == 1) {
-                dirty_bits[page_index] = 1;
+        process->page_faults++;
+        if (pool->pff) {
+            long long interval = process->references - process->last_fault;
+            process->last_fault = process->references;
+            if (interval <= pool->pff_low && unallocated > 0) {
+                process->allocation++;
+                unallocated--;
+            } else if (interval > pool->pff_high && process->allocation > 1) {
+                process->allocation--;
+                unallocated++;
             }
         }
 
-        current_time++;
+        // A shrunken allocation can take two evictions to make room, otherwise at most one is needed
+        while (pool->local ? list->size >= process->allocation : list->size == pool->frames) {
+            int victim = list->tail;
+            ProcessState *victim_process = &processes[owner != NULL ? owner[victim] : 0];
+            frameListUnlink(list, prev, next, victim);
+            resident[victim] = 0;
+            victim_process->resident--;
+            if (dirty[victim]) {
+                victim_process->writeBacks++;
+            }
+        }
+        frameListPushFront(list, prev, next, page);
+        resident[page] = 1;
+        dirty[page] = pages[i].dirty == 1;
+        process->resident++;
     }
 
-    printf("| %-6d | %-12d | %-11d |\n", frame_count, page_faults, writeBacks);
-    printf("+--------+--------------+-------------+\n");
+    free(prev);
+    free(next);
+    free(resident);
+    free(dirty);
+    return true;
+}
+
+// Function to print the faults and write-backs of every process and of the whole pool
+void printProcessResults(const ProcessState processes[], int process_count, const int *original_pid) {
+    long long references = 0;
+    long long page_faults = 0;
+    long long writeBacks = 0;
+    int frames = 0;
 
-    free(frames);
-    free(access_time);
-    free(dirty_bits);
+    printf("+-------------+--------------+--------------+--------------+--------+\n");
+    printf("| Process     | References   | Page Faults  | Write backs  | Frames |\n");
+    printf("+-------------+--------------+--------------+--------------+--------+\n");
+    for (int p = 0; p < process_count; p++) {
+        const ProcessState *process = &processes[p];
+        printf("| %-11d | %-12lld | %-12lld | %-12lld | %-6d |\n", original_pid != NULL ? original_pid[p] : 0,
+               process->references, process->page_faults, process->writeBacks, process->resident);
+        references += process->references;
+        page_faults += process->page_faults;
+        writeBacks += process->writeBacks;
+        frames += process->resident;
+    }
+    printf("+-------------+--------------+--------------+--------------+--------+\n");
+    printf("| %-11s | %-12lld | %-12lld | %-12lld | %-6d |\n", "Total", references, page_faults, writeBacks, frames);
+    printf("+-------------+--------------+--------------+--------------+--------+\n");
 }
 
 // Main function
 int main(int argc, char *argv[]) {
     // Check if the user has provided the correct number of arguments
-    if (argc != 2) {
-        fprintf(stderr, "Error: Please provide 2 arguments (pageReplacementAlgorithm < inputFile).\n");
+    if (argc < 2) {
+        fprintf(stderr, "Error: Please provide 2 arguments (pageReplacementAlgorithm [--threads N] [--stream | --fused] [--no-remap] [--cache DIR] [--bits N --period M] [--stats FILE] < inputFile, WS [--tau T,...] or PFF [--pff LOW,HIGH:...] < inputFile, SHARDS [--rate R] [--samples S] [--frames N] [--verify] < inputFile, MULTI [--frames N] [--scope global|local] [--alloc proportional|pff] [--pff LOW,HIGH] < inputFile, or CONVERT --output traceFile [--varint] < inputFile).\n");
         return EXIT_FAILURE;
     }
 
-    char buffer[256];
-    
-    // Count the number of lines in the input
-    int lineCount = 0;
-    while (fgets(buffer, sizeof(buffer), stdin) != NULL) {
-        lineCount++;
+    // Parse the options that follow the algorithm name
+    int thread_count = 1;
+    const char *output_path = NULL; // Binary trace written by CONVERT
+    int encoding = TRACE_FIXED;
+    bool streaming = false;
+    bool fused = false; // Run the sweep through the fused engine, implied by a list of policies
+    SimOptions options = {8, 10, 0, NULL, false}; // Second Chance defaults to n = 8, m = 10 like secondChance.c
+    bool remap_pages = true;
+    const char *cache_dir = NULL; // Preprocessed traces are kept here by --cache
+    PoolOptions pool = {SWEEP_FRAMES, false, false, 10, 100}; // MULTI defaults to global replacement
+    bool multi_thresholds = false; // --pff gave several pairs, which only a PFF sweep takes
+    double shards_rate = -1;       // SHARDS sampling rate, 0.01 unless given (1 to start with for --samples)
+    int shards_samples = 0;        // SHARDS page budget, 0 for a fixed rate
+    bool verify = false;           // SHARDS also runs the exact LRU curve and reports the error
+    // WS and PFF sweep windows and thresholds from 1 to 10000 references by default
+    VariableOptions variable = {{1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000}, 13,
+                                {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000},
+                                {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000}, 10};
+#ifdef PR_STATS
+    const char *stats_path = NULL; // JSON counters written by --stats
+#endif
+    for (int arg = 2; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+            char *end;
+            long value = strtol(argv[++arg], &end, 10);
+            if (*end != '\0' || value < 1 || value > 4096) {
+                fprintf(stderr, "Error: --threads expects a thread count between 1 and 4096.\n");
+                return EXIT_FAILURE;
+            }
+            thread_count = (int)value;
+        } else if (strcmp(argv[arg], "--output") == 0 && arg + 1 < argc) {
+            output_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--varint") == 0) {
+            encoding = TRACE_VARINT;
+        } else if (strcmp(argv[arg], "--stream") == 0) {
+            streaming = true;
+        } else if (strcmp(argv[arg], "--fused") == 0) {
+            fused = true;
+        } else if (strcmp(argv[arg], "--no-remap") == 0) {
+            remap_pages = false;
+        } else if (strcmp(argv[arg], "--cache") == 0 && arg + 1 < argc) {
+            cache_dir = argv[++arg];
+        } else if (strcmp(argv[arg], "--frames") == 0 && arg + 1 < argc) {
+            char *end;
+            long value = strtol(argv[++arg], &end, 10);
+            if (*end != '\0' || value < 1 || value > INT_MAX) {
+                fprintf(stderr, "Error: --frames expects a positive frame count.\n");
+                return EXIT_FAILURE;
+            }
+            pool.frames = (int)value;
+        } else if (strcmp(argv[arg], "--scope") == 0 && arg + 1 < argc) {
+            arg++;
+            if (strcmp(argv[arg], "global") != 0 && strcmp(argv[arg], "local") != 0) {
+                fprintf(stderr, "Error: --scope expects global or local.\n");
+                return EXIT_FAILURE;
+            }
+            pool.local = strcmp(argv[arg], "local") == 0;
+        } else if (strcmp(argv[arg], "--alloc") == 0 && arg + 1 < argc) {
+            arg++;
+            if (strcmp(argv[arg], "proportional") != 0 && strcmp(argv[arg], "pff") != 0) {
+                fprintf(stderr, "Error: --alloc expects proportional or pff.\n");
+                return EXIT_FAILURE;
+            }
+            pool.pff = strcmp(argv[arg], "pff") == 0;
+        } else if (strcmp(argv[arg], "--pff") == 0 && arg + 1 < argc) {
+            // One LOW,HIGH pair for MULTI, or several separated by ':' for a PFF sweep
+            char *end = argv[++arg] - 1;
+            variable.threshold_count = 0;
+            do {
+                long low = strtol(end + 1, &end, 10);
+                long high = *end == ',' ? strtol(end + 1, &end, 10) : -1;
+                if ((*end != '\0' && *end != ':') || low < 1 || high < low || high > INT_MAX ||
+                    variable.threshold_count == MAX_SWEEP_VALUES) {
+                    fprintf(stderr, "Error: --pff expects up to %d LOW,HIGH reference intervals with 1 <= LOW <= HIGH, separated by ':'.\n", MAX_SWEEP_VALUES);
+                    return EXIT_FAILURE;
+                }
+                variable.lows[variable.threshold_count] = (int)low;
+                variable.highs[variable.threshold_count++] = (int)high;
+            } while (*end == ':');
+            pool.pff_low = variable.lows[0];
+            pool.pff_high = variable.highs[0];
+            multi_thresholds = variable.threshold_count > 1;
+        } else if (strcmp(argv[arg], "--rate") == 0 && arg + 1 < argc) {
+            char *end;
+            shards_rate = strtod(argv[++arg], &end);
+            if (*end != '\0' || !(shards_rate * (1 << SHARDS_HASH_BITS) >= 1 && shards_rate <= 1)) {
+                fprintf(stderr, "Error: --rate expects a sampling rate between 2^-%d and 1.\n", SHARDS_HASH_BITS);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--samples") == 0 && arg + 1 < argc) {
+            char *end;
+            long value = strtol(argv[++arg], &end, 10);
+            if (*end != '\0' || value < 1 || value > INT_MAX - 1) {
+                fprintf(stderr, "Error: --samples expects a positive page count.\n");
+                return EXIT_FAILURE;
+            }
+            shards_samples = (int)value;
+        } else if (strcmp(argv[arg], "--verify") == 0) {
+            verify = true;
+        } else if (strcmp(argv[arg], "--tau") == 0 && arg + 1 < argc) {
+            char *end = argv[++arg] - 1;
+            variable.tau_count = 0;
+            do {
+                long tau = strtol(end + 1, &end, 10);
+                if ((*end != '\0' && *end != ',') || tau < 1 || tau > INT_MAX || variable.tau_count == MAX_SWEEP_VALUES) {
+                    fprintf(stderr, "Error: --tau expects up to %d positive windows separated by ','.\n", MAX_SWEEP_VALUES);
+                    return EXIT_FAILURE;
+                }
+                variable.taus[variable.tau_count++] = (int)tau;
+            } while (*end == ',');
+        } else if (strcmp(argv[arg], "--stats") == 0 && arg + 1 < argc) {
+#ifdef PR_STATS
+            stats_path = argv[++arg];
+#else
+            fprintf(stderr, "Error: --stats needs a build with -DPR_STATS.\n");
+            return EXIT_FAILURE;
+#endif
+        } else if ((strcmp(argv[arg], "--bits") == 0 || strcmp(argv[arg], "--period") == 0) && arg + 1 < argc) {
+            bool bits = strcmp(argv[arg], "--bits") == 0;
+            char *end;
+            long value = strtol(argv[++arg], &end, 10);
+            if (*end != '\0' || value < 1 || value > (bits ? 32 : INT_MAX)) {
+                fprintf(stderr, "Error: %s expects a value between 1 and %d.\n", argv[arg - 1], bits ? 32 : INT_MAX);
+                return EXIT_FAILURE;
+            }
+            *(bits ? &options.aging_bits : &options.aging_period) = (int)value;
+        } else {
+            fprintf(stderr, "Error: Unknown option %s.\n", argv[arg]);
+            return EXIT_FAILURE;
+        }
     }
 
-    // Rewind the file pointer to read the data again
-    rewind(stdin);
+    // Pick the vector width of the small-pool lookup kernel
+    detectSimd();
 
-    // Allocate memory for the pages
-    Page *pages = malloc(lineCount * sizeof(Page));
-    if (pages == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        return EXIT_FAILURE;
+    // Streaming simulates while reading, without keeping the trace
+    if (streaming) {
+        Policy policy;
+        if (!simulationPolicy(argv[1], &policy)) {
+            fprintf(stderr, "Error: --stream supports FIFO, LRU, SC, ARC and WTINYLFU.\n");
+            return EXIT_FAILURE;
+        }
+        printf("+--------+--------------+-------------+\n");
+        printf("| Frames | Page Faults  | Write backs |\n");
+        printf("+--------+--------------+-------------+\n");
+        STAT_CLOCK(stream_start);
+        int status = streamSweep(STDIN_FILENO, policy, SWEEP_FRAMES, &options, thread_count);
+        STAT_PHASE(simulate, stream_start); // Reading is interleaved with simulating, so it is all one phase
+#ifdef PR_STATS
+        if (stats_path != NULL && !statsWrite(stats_path, argv[1], statRunCount > 0 ? statRuns[0].stats.references : 0, 0)) {
+            perror("Error: Cannot write the stats file");
+            status = EXIT_FAILURE;
+        }
+#endif
+        return status;
     }
 
-    // Read and store each Page
-    int i = 0;
-    while (fgets(buffer, sizeof(buffer), stdin) != NULL && i < lineCount) {
-        sscanf(buffer, "%d,%d", &pages[i].page_number, &pages[i].dirty);
-        i++;
+    // Read and store each Page in one pass over the input, or map it already preprocessed from the cache
+    STAT_CLOCK(load_start);
+    Trace trace;
+    PageRemap remap = {NULL, 0, NULL, NULL, 0};
+    int *next_use = NULL; // The next-use index of OPT is shared by every frame count
+    TraceCache cache = {NULL, 0};
+    bool prepared = cache_dir != NULL && remap_pages && strcmp(argv[1], "CONVERT") != 0 &&
+                    loadCachedTrace(STDIN_FILENO, cache_dir, &trace, &remap, &next_use, &cache);
+    if (cache_dir != NULL && !prepared) {
+        fprintf(stderr, "Note: --cache needs a trace file on stdin and remapped pages, running without it.\n");
+    }
+    if (!prepared) {
+        loadTrace(STDIN_FILENO, &trace);
+    }
+    STAT_PHASE(load, load_start);
+    Page *pages = trace.pages;
+    int count = trace.count;
+
+    // CONVERT rewrites the input as a binary trace instead of simulating it
+    if (strcmp(argv[1], "CONVERT") == 0) {
+        int status = EXIT_FAILURE;
+        if (output_path == NULL) {
+            fprintf(stderr, "Error: CONVERT needs --output <binary trace>.\n");
+        } else {
+            status = convertTrace(&trace, output_path, encoding);
+        }
+        releaseTrace(&trace, &remap, next_use, &cache);
+        return status;
+    }
+
+    // Renumber the pages densely so the engines can use flat arrays, the original numbers stay in remap
+    STAT_CLOCK(preprocess_start);
+    if (remap_pages && !prepared) {
+        remapTrace(&trace, &remap);
+    }
+    if (remap_pages) {
+        options.universe = remap.unique;
+        options.original = remap.original;
+    }
+    if (next_use == NULL && (strcmp(argv[1], "OPT") == 0 || strcmp(argv[1], "OPTSTACK") == 0)) {
+        next_use = buildNextUse(pages, count, options.universe);
+    }
+    STAT_PHASE(preprocess, preprocess_start);
+
+    // MULTI shares one pool of frames between the processes of the PID column
+    if (strcmp(argv[1], "MULTI") == 0) {
+        int status = EXIT_FAILURE;
+        int process_count = remap.processes > 0 ? remap.processes : 1;
+        ProcessState *processes = checkedMalloc(process_count * sizeof(ProcessState));
+        if (!remap_pages) {
+            fprintf(stderr, "Error: MULTI needs remapped pages, drop --no-remap.\n");
+        } else if (pool.pff && !pool.local) {
+            fprintf(stderr, "Error: --alloc applies to --scope local.\n");
+        } else if (multi_thresholds) {
+            fprintf(stderr, "Error: MULTI takes a single --pff LOW,HIGH pair.\n");
+        } else if (!multiProcessRun(pages, trace.pids, count, remap.owner, remap.unique, processes, process_count,
+                                    &pool)) {
+            fprintf(stderr, "Error: Local replacement needs at least one frame for each of the %d processes.\n",
+                    process_count);
+        } else {
+            printf("%d frames, %s replacement%s\n", pool.frames, pool.local ? "local" : "global",
+                   pool.local ? (pool.pff ? ", page-fault frequency allocation" : ", proportional allocation") : "");
+            printProcessResults(processes, process_count, remap.originalPid);
+            status = EXIT_SUCCESS;
+        }
+        free(processes);
+        releaseTrace(&trace, &remap, next_use, &cache);
+        return status;
+    }
+
+    // WS and PFF let the resident set vary, so they sweep their window or thresholds instead of frame counts
+    if (strcmp(argv[1], "WS") == 0 || strcmp(argv[1], "PFF") == 0) {
+        int status = EXIT_SUCCESS;
+        if (!remap_pages) {
+            fprintf(stderr, "Error: %s needs remapped pages, drop --no-remap.\n", argv[1]);
+            status = EXIT_FAILURE;
+        } else {
+            STAT_CLOCK(simulate_start);
+            variableSweep(strcmp(argv[1], "PFF") == 0, pages, count, remap.unique, &variable, thread_count);
+            STAT_PHASE(simulate, simulate_start);
+        }
+        releaseTrace(&trace, &remap, next_use, &cache);
+        return status;
+    }
+
+    // SHARDS estimates the LRU curve from a sample, up to --frames frames
+    if (strcmp(argv[1], "SHARDS") == 0) {
+        if (shards_rate < 0) {
+            shards_rate = shards_samples > 0 ? 1 : 0.01;
+        }
+        STAT_CLOCK(simulate_start);
+        shardsCurve(pages, count, pool.frames, shards_rate, shards_samples, verify);
+        STAT_PHASE(simulate, simulate_start);
+        releaseTrace(&trace, &remap, next_use, &cache);
+        return EXIT_SUCCESS;
+    }
+
+    // A list of policies such as FIFO,LRU,SC, or --fused, advances every simulation in one pass over the trace
+    if (fused || strchr(argv[1], ',') != NULL) {
+        Policy policies[MAX_FUSED_POLICIES];
+        char *names[MAX_FUSED_POLICIES];
+        int policy_count = 0;
+        int status = EXIT_SUCCESS;
+        for (char *name = strtok(argv[1], ","); name != NULL && status == EXIT_SUCCESS; name = strtok(NULL, ",")) {
+            if (policy_count == MAX_FUSED_POLICIES || !simulationPolicy(name, &policies[policy_count])) {
+                fprintf(stderr, "Error: A fused run takes up to %d of FIFO, LRU, SC, ARC and WTINYLFU.\n",
+                        MAX_FUSED_POLICIES);
+                status = EXIT_FAILURE;
+            } else {
+                names[policy_count++] = name;
+            }
+        }
+        if (status == EXIT_SUCCESS && policy_count > 0) {
+            STAT_CLOCK(simulate_start);
+            fusedSweep(policies, names, policy_count, pages, count, SWEEP_FRAMES, &options, thread_count);
+            STAT_PHASE(simulate, simulate_start);
+#ifdef PR_STATS
+            if (stats_path != NULL && !statsWrite(stats_path, argv[1], count, options.universe)) {
+                perror("Error: Cannot write the stats file");
+                status = EXIT_FAILURE;
+            }
+#endif
+        }
+        releaseTrace(&trace, &remap, next_use, &cache);
+        return status;
     }
 
     // Print the header for output
@@ -279,26 +3885,45 @@ int main(int argc, char *argv[]) {
     printf("+--------+--------------+-------------+\n");
 
     // Process using FIFO if it is the selected scheduler
+    STAT_CLOCK(simulate_start);
     if (strcmp(argv[1], "FIFO") == 0) {
-        for (int i = 1; i < 101; i++) {
-            FIFO(pages, lineCount-1, i);
-        }
+        runSweep(POLICY_FIFO, pages, count, SWEEP_FRAMES, NULL, &options, thread_count);
     } else if (strcmp(argv[1], "OPT") == 0) {
-        for (int i = 1; i < 101; i++) {
-            Optimal(pages, lineCount-1, i);
-        }
+        runSweep(POLICY_OPT, pages, count, SWEEP_FRAMES, next_use, &options, thread_count);
+    } else if (strcmp(argv[1], "OPTSTACK") == 0) {
+        // All OPT frame counts from one pass over the trace
+        OptimalStack(pages, count, SWEEP_FRAMES, next_use);
     } else if (strcmp(argv[1], "LRU") == 0) {
-        for (int i = 1; i < 101; i++) {
-            LRU(pages, lineCount-1, i);
-        }
+        runSweep(POLICY_LRU, pages, count, SWEEP_FRAMES, NULL, &options, thread_count);
+    } else if (strcmp(argv[1], "LRUSTACK") == 0) {
+        // All LRU frame counts from one pass over the trace
+        LRUStack(pages, count, SWEEP_FRAMES);
+    } else if (strcmp(argv[1], "SC") == 0) {
+        // Second Chance with n-bit reference registers shifted every m references
+        runSweep(POLICY_SC, pages, count, SWEEP_FRAMES, NULL, &options, thread_count);
+    } else if (strcmp(argv[1], "ARC") == 0) {
+        // Adaptive Replacement Cache, balancing recency against frequency to resist scans
+        runSweep(POLICY_ARC, pages, count, SWEEP_FRAMES, NULL, &options, thread_count);
+    } else if (strcmp(argv[1], "WTINYLFU") == 0) {
+        // Window LRU in front of a segmented LRU, admission decided by a frequency sketch
+        runSweep(POLICY_WTINYLFU, pages, count, SWEEP_FRAMES, NULL, &options, thread_count);
     } else {
         fprintf(stderr, "Error: Invalid page replacement algorithm specified.\n");
-        free(pages);
+        releaseTrace(&trace, &remap, next_use, &cache);
         return EXIT_FAILURE;
     }
+    STAT_PHASE(simulate, simulate_start);
+
+    int status = EXIT_SUCCESS;
+#ifdef PR_STATS
+    if (stats_path != NULL && !statsWrite(stats_path, argv[1], count, options.universe)) {
+        perror("Error: Cannot write the stats file");
+        status = EXIT_FAILURE;
+    }
+#endif
 
     // Free the memory allocated for the pages
-    free(pages);
+    releaseTrace(&trace, &remap, next_use, &cache);
 
-    return EXIT_SUCCESS;
+    return status;
 }
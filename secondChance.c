@@ -1,6 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h> // Build with -pthread
+#include <stdatomic.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #define MAX_FRAMES 50
 
@@ -10,148 +17,1275 @@ typedef struct {
     int dirty;                  
 } Page;
 
-Page *frames;
-int num_frames = MAX_FRAMES;
-int write_back_count = 0;  //Count the number of write backs
+//State of one simulation run, every run owns its own so runs can proceed in parallel
+//The frame table is kept as separate packed arrays so the aging and victim kernels can work on whole vectors
+typedef struct {
+    int *page_numbers;            //Page held by each frame, -1 when empty
+    unsigned int *ref_registers;  //Reference register of n bits for each frame
+    int *dirty;
+    int num_frames;
+    int write_back_count;  //Count the number of write backs
+} SecondChanceContext;
 
-//function to find a page in the frame
-int find_page_in_frames(int page_number) {
-    for (int i = 0; i < num_frames; i++) {
-        if (frames[i].page_number == page_number) {
+//Vector width of the kernels, detected once at startup by detect_simd
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_AVX2
+} SimdLevel;
+
+static SimdLevel simd_level = SIMD_SCALAR;
+
+void detect_simd(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        simd_level = SIMD_AVX2;
+    }
+#endif
+}
+
+//Function to allocate a context with room for num_frames frames
+void init_context(SecondChanceContext *ctx, int num_frames) {
+    ctx->page_numbers = malloc(num_frames * sizeof(int));
+    ctx->ref_registers = malloc(num_frames * sizeof(unsigned int));
+    ctx->dirty = malloc(num_frames * sizeof(int));
+    if (ctx->page_numbers == NULL || ctx->ref_registers == NULL || ctx->dirty == NULL) {
+        perror("Failed to allocate memory");
+        exit(1);
+    }
+    ctx->num_frames = num_frames;
+    ctx->write_back_count = 0;
+}
+
+void free_context(SecondChanceContext *ctx) {
+    free(ctx->page_numbers);
+    free(ctx->ref_registers);
+    free(ctx->dirty);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static int find_page_avx2(const int *page_numbers, int num_frames, int page_number) {
+    __m256i needle = _mm256_set1_epi32(page_number);
+    int i = 0;
+    for (; i + 8 <= num_frames; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(page_numbers + i));
+        unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; i < num_frames; i++) {
+        if (page_numbers[i] == page_number) {
             return i;
         }
     }
     return -1;
 }
 
-//Function to check if all reference registers are equal
-int all_ref_registers_equal() {
-    unsigned int first_reg = frames[0].ref_register;
-    for (int i = 1; i < num_frames; i++) {
-        if (frames[i].ref_register != first_reg) {
-            return 0;  //Registers are not equal
+__attribute__((target("avx2")))
+static void age_registers_avx2(unsigned int *registers, int num_frames, unsigned int register_mask) {
+    __m256i mask = _mm256_set1_epi32((int)register_mask);
+    int i = 0;
+    for (; i + 8 <= num_frames; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(registers + i));
+        _mm256_storeu_si256((__m256i *)(registers + i), _mm256_and_si256(_mm256_srli_epi32(block, 1), mask));
+    }
+    for (; i < num_frames; i++) {
+        registers[i] = (registers[i] >> 1) & register_mask;
+    }
+}
+
+//Each lane keeps its lowest register and the first index holding it plus its highest register,
+//the lanes are then reduced to the first index of the overall minimum
+__attribute__((target("avx2")))
+static int find_victim_avx2(const unsigned int *registers, int num_frames, int *all_equal) {
+    int i = 0;
+    unsigned int lowest_value = registers[0];
+    unsigned int highest_value = registers[0];
+    int lowest_index = 0;
+
+    if (num_frames >= 8) {
+        __m256i lane_min = _mm256_loadu_si256((const __m256i *)registers);
+        __m256i lane_max = lane_min;
+        __m256i lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i index = lane_index;
+        __m256i step = _mm256_set1_epi32(8);
+        for (i = 8; i + 8 <= num_frames; i += 8) {
+            __m256i block = _mm256_loadu_si256((const __m256i *)(registers + i));
+            index = _mm256_add_epi32(index, step);
+            __m256i smaller = _mm256_min_epu32(block, lane_min);
+            //A lane takes the new index only when the new register is strictly lower
+            __m256i unchanged = _mm256_cmpeq_epi32(smaller, lane_min);
+            lane_index = _mm256_blendv_epi8(index, lane_index, unchanged);
+            lane_min = smaller;
+            lane_max = _mm256_max_epu32(block, lane_max);
+        }
+
+        unsigned int mins[8], maxs[8];
+        int indexes[8];
+        _mm256_storeu_si256((__m256i *)mins, lane_min);
+        _mm256_storeu_si256((__m256i *)maxs, lane_max);
+        _mm256_storeu_si256((__m256i *)indexes, lane_index);
+        lowest_value = mins[0];
+        highest_value = maxs[0];
+        lowest_index = indexes[0];
+        for (int lane = 1; lane < 8; lane++) {
+            if (mins[lane] < lowest_value || (mins[lane] == lowest_value && indexes[lane] < lowest_index)) {
+                lowest_value = mins[lane];
+                lowest_index = indexes[lane];
+            }
+            if (maxs[lane] > highest_value) {
+                highest_value = maxs[lane];
+            }
+        }
+    }
+
+    for (; i < num_frames; i++) {
+        if (registers[i] < lowest_value) {
+            lowest_value = registers[i];
+            lowest_index = i;
+        }
+        if (registers[i] > highest_value) {
+            highest_value = registers[i];
+        }
+    }
+    *all_equal = lowest_value == highest_value;
+    return lowest_index;
+}
+#endif
+
+//function to find a page in the frame
+int find_page_in_frames(const SecondChanceContext *ctx, int page_number) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (simd_level == SIMD_AVX2) {
+        return find_page_avx2(ctx->page_numbers, ctx->num_frames, page_number);
+    }
+#endif
+    for (int i = 0; i < ctx->num_frames; i++) {
+        if (ctx->page_numbers[i] == page_number) {
+            return i;
         }
     }
-    return 1;  //All registers are equal
+    return -1;
+}
+
+//Function to shift every reference register right by one, keeping only the n bits
+void age_registers(SecondChanceContext *ctx, unsigned int register_mask) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (simd_level == SIMD_AVX2) {
+        age_registers_avx2(ctx->ref_registers, ctx->num_frames, register_mask);
+        return;
+    }
+#endif
+    for (int j = 0; j < ctx->num_frames; j++) {
+        ctx->ref_registers[j] = (ctx->ref_registers[j] >> 1) & register_mask;
+    }
 }
 
-//Function to find the index of the page with the lowest reference register
-int find_lowest_reference_page() {
+//Function to find the index of the page with the lowest reference register (the first one on ties)
+//and, in the same pass, whether all reference registers are equal
+int find_lowest_reference_page(const SecondChanceContext *ctx, int *all_equal) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (simd_level == SIMD_AVX2) {
+        return find_victim_avx2(ctx->ref_registers, ctx->num_frames, all_equal);
+    }
+#endif
+    const unsigned int *registers = ctx->ref_registers;
     int lowest_index = 0;
-    unsigned int lowest_value = frames[0].ref_register;
-    for (int i = 1; i < num_frames; i++) {
-        if (frames[i].ref_register < lowest_value) {
+    unsigned int highest_value = registers[0];
+    for (int i = 1; i < ctx->num_frames; i++) {
+        if (registers[i] < registers[lowest_index]) {
             lowest_index = i;
-            lowest_value = frames[i].ref_register;
+        }
+        if (registers[i] > highest_value) {
+            highest_value = registers[i];
         }
     }
+    *all_equal = registers[lowest_index] == highest_value;
     return lowest_index;
 }
 
 //Function to find the replacement index in the Second Chance
-int get_replacement_index(int *clock_hand, int n) {
+int get_replacement_index(const SecondChanceContext *ctx, int *clock_hand, int n) {
+    int all_equal;
+    int lowest_index = find_lowest_reference_page(ctx, &all_equal);
+
     //If all reference registers are equal then fall back to FIFO
-    if (all_ref_registers_equal()) {
+    if (all_equal) {
         int oldest_index = *clock_hand;
-        *clock_hand = (*clock_hand + 1) % num_frames;
+        *clock_hand = (*clock_hand + 1) % ctx->num_frames;
         return oldest_index;  // FIFO tiebreaker
     }
 
     //replace the page with the lowest reference register
-    return find_lowest_reference_page();
+    return lowest_index;
 }
 //Simulate the Second Chance algorithm with reference registers
-int simulate_second_chance(Page *listOfPages, int num_pages, int n, int m) {
+//The write backs of the run are left in ctx->write_back_count
+int simulate_second_chance(SecondChanceContext *ctx, Page *listOfPages, int num_pages, int n, int m) {
     int page_faults = 0;
     int clock_hand = 0;
     int reference_count = 0;
-    write_back_count = 0;  //Reset the write back count for each experiment
+    unsigned int leftmost_bit = 1u << (n - 1);
+    unsigned int register_mask = n >= 32 ? ~0u : (1u << n) - 1;  //Keep only the n bits in the register
+    ctx->write_back_count = 0;  //Reset the write back count for each experiment
 
     //Initialize frames
-    for (int i = 0; i < num_frames; i++) {
-        frames[i].page_number = -1;  //This is an empty frame
-        frames[i].ref_register = 0;  //Initialize the reference register to 0
-        frames[i].dirty = 0;
+    for (int i = 0; i < ctx->num_frames; i++) {
+        ctx->page_numbers[i] = -1;  //This is an empty frame
+        ctx->ref_registers[i] = 0;  //Initialize the reference register to 0
+        ctx->dirty[i] = 0;
     }
 
     for (int i = 0; i < num_pages; i++) {
         int page_number = listOfPages[i].page_number; //Get the current page number from the list of pages
         int dirty_bit = listOfPages[i].dirty;  //Get the dirty bit 
-        int page_index = find_page_in_frames(page_number);
+        int page_index = find_page_in_frames(ctx, page_number);
 
         if (page_index == -1) {
             //Page fault 
             page_faults++;
 
             //Find replacement page using clock hand
-            int replace_index = get_replacement_index(&clock_hand, n);
+            int replace_index = get_replacement_index(ctx, &clock_hand, n);
 
             //Simulate writeback if the page to be replaced is dirty
-            if (frames[replace_index].dirty == 1) {
-                write_back_count++;
+            if (ctx->dirty[replace_index] == 1) {
+                ctx->write_back_count++;
             }
 
             //Replace the page in frames
-            frames[replace_index].page_number = page_number;
-            frames[replace_index].ref_register = (1 << (n - 1));  //Set the leftmost bit of the register
-            frames[replace_index].dirty = dirty_bit;  //Set the dirty bit for the new page
+            ctx->page_numbers[replace_index] = page_number;
+            ctx->ref_registers[replace_index] = leftmost_bit;  //Set the leftmost bit of the register
+            ctx->dirty[replace_index] = dirty_bit;  //Set the dirty bit for the new page
         } else {
             //if the page is found set the leftmost bit of the reference register and update dirty bit
-            frames[page_index].ref_register |= (1 << (n - 1));  //Set leftmost bit of the register
-            frames[page_index].dirty = dirty_bit;  //Update the dirty bit
+            ctx->ref_registers[page_index] |= leftmost_bit;  //Set leftmost bit of the register
+            ctx->dirty[page_index] = dirty_bit;  //Update the dirty bit
         }
 
         //Increment reference count and check if we need to shift the registers
         reference_count++;
         if (reference_count == m) {
-            //Shift reference registers
-            for (int j = 0; j < num_frames; j++) {
-                frames[j].ref_register >>= 1;  //Shift reference register to the right
-                frames[j].ref_register &= (1 << n) - 1;  //Keep only the n bits in the register
+            age_registers(ctx, register_mask);
+            reference_count = 0;
+        }
+    }
+
+    return page_faults;
+}
+
+//Open addressing page -> frame table for the lazy mode, linear probing with backward shift deletion
+typedef struct {
+    int *keys;    //Page number in each slot, -1 when empty
+    int *values;  //Frame holding that page
+    unsigned int mask;
+} PageTable;
+
+void page_table_init(PageTable *table, int num_frames) {
+    unsigned int capacity = 16;
+    while (capacity < 2u * (unsigned int)num_frames) {
+        capacity <<= 1;
+    }
+    table->keys = malloc(capacity * sizeof(int));
+    table->values = malloc(capacity * sizeof(int));
+    if (table->keys == NULL || table->values == NULL) {
+        perror("Failed to allocate memory");
+        exit(1);
+    }
+    memset(table->keys, -1, capacity * sizeof(int));
+    table->mask = capacity - 1;
+}
+
+void page_table_free(PageTable *table) {
+    free(table->keys);
+    free(table->values);
+}
+
+static unsigned int page_table_bucket(const PageTable *table, int page_number) {
+    return ((unsigned int)page_number * 2654435769u) & table->mask;
+}
+
+int page_table_find(const PageTable *table, int page_number) {
+    for (unsigned int slot = page_table_bucket(table, page_number);; slot = (slot + 1) & table->mask) {
+        if (table->keys[slot] == page_number) {
+            return table->values[slot];
+        }
+        if (table->keys[slot] == -1) {
+            return -1;
+        }
+    }
+}
+
+void page_table_insert(PageTable *table, int page_number, int frame) {
+    unsigned int slot = page_table_bucket(table, page_number);
+    while (table->keys[slot] != -1) {
+        slot = (slot + 1) & table->mask;
+    }
+    table->keys[slot] = page_number;
+    table->values[slot] = frame;
+}
+
+void page_table_remove(PageTable *table, int page_number) {
+    unsigned int slot = page_table_bucket(table, page_number);
+    while (table->keys[slot] != page_number) {
+        slot = (slot + 1) & table->mask;
+    }
+    //Shift later entries of the probe run back so no tombstones are needed
+    for (unsigned int next = (slot + 1) & table->mask; table->keys[next] != -1; next = (next + 1) & table->mask) {
+        unsigned int home = page_table_bucket(table, table->keys[next]);
+        if (((next - home) & table->mask) >= ((next - slot) & table->mask)) {
+            table->keys[slot] = table->keys[next];
+            table->values[slot] = table->values[next];
+            slot = next;
+        }
+    }
+    table->keys[slot] = -1;
+}
+
+//Frames of the lazy mode are grouped by the epoch of their last reference. Epoch e lives in bucket e % n.
+//Every frame in a bucket was last updated in the same epoch, so all of their registers have missed the same
+//number of shifts and keep their relative order. Each bucket is a binary trie keyed on the stored register,
+//most significant bit first, followed by the frame index, and each node keeps the lowest frame index below
+//it. Once a bucket is n epochs old every register in it has shifted to 0, so its frames move to the expired
+//set, a bitmap with a summary word per 64 words so the lowest expired frame is found with two ctz
+typedef struct {
+    int child[2];
+    int count;         //Frames below this node
+    int lowest_frame;  //Lowest frame index below this node
+} TrieNode;
+
+typedef struct {
+    TrieNode *nodes;
+    int node_capacity;
+    int free_node;     //Free list of nodes threaded through child[0]
+    int *roots;        //Trie of each bucket, -1 when the bucket is empty
+    int *last_epoch;   //Epoch in which each frame's register was last updated
+    int index_bits;    //Bits needed for a frame index
+    int key_bits;      //n register bits followed by the index bits
+    unsigned long long occupied;  //Bit b set when bucket b is not empty
+    unsigned long long *expired;
+    unsigned long long *expired_summary;  //Bit w set when word w of expired is not empty
+    int expired_count;
+    int n;
+} EpochBuckets;
+
+static int trie_node_new(EpochBuckets *buckets) {
+    if (buckets->free_node == -1) {
+        int capacity = buckets->node_capacity * 2;
+        TrieNode *nodes = realloc(buckets->nodes, capacity * sizeof(TrieNode));
+        if (nodes == NULL) {
+            perror("Failed to allocate memory");
+            exit(1);
+        }
+        for (int i = buckets->node_capacity; i < capacity; i++) {
+            nodes[i].child[0] = i + 1 < capacity ? i + 1 : -1;
+        }
+        buckets->free_node = buckets->node_capacity;
+        buckets->nodes = nodes;
+        buckets->node_capacity = capacity;
+    }
+    int node = buckets->free_node;
+    buckets->free_node = buckets->nodes[node].child[0];
+    buckets->nodes[node].child[0] = buckets->nodes[node].child[1] = -1;
+    buckets->nodes[node].count = 0;
+    buckets->nodes[node].lowest_frame = -1;
+    return node;
+}
+
+static void trie_node_free(EpochBuckets *buckets, int node) {
+    buckets->nodes[node].child[0] = buckets->free_node;
+    buckets->free_node = node;
+}
+
+//Bit of the trie key at the given depth: the register bits from the leftmost down, then the frame index bits
+static int trie_side(const EpochBuckets *buckets, unsigned int key, int frame, int depth) {
+    if (depth < buckets->n) {
+        return (key >> (buckets->n - 1 - depth)) & 1;
+    }
+    return (frame >> (buckets->key_bits - 1 - depth)) & 1;
+}
+
+static void bucket_insert(EpochBuckets *buckets, int b, unsigned int key, int frame) {
+    if (buckets->roots[b] == -1) {
+        buckets->roots[b] = trie_node_new(buckets);
+    }
+    int node = buckets->roots[b];
+    for (int depth = 0;; depth++) {
+        TrieNode *t = &buckets->nodes[node];
+        t->count++;
+        if (t->lowest_frame == -1 || frame < t->lowest_frame) {
+            t->lowest_frame = frame;
+        }
+        if (depth == buckets->key_bits) {
+            break;
+        }
+        int side = trie_side(buckets, key, frame, depth);
+        if (buckets->nodes[node].child[side] == -1) {
+            int child = trie_node_new(buckets);  //May move the node array
+            buckets->nodes[node].child[side] = child;
+        }
+        node = buckets->nodes[node].child[side];
+    }
+    buckets->occupied |= 1ull << b;
+}
+
+static void bucket_unlink(EpochBuckets *buckets, int b, unsigned int key, int frame) {
+    int path[64];  //key_bits is at most 32 + 31
+    int node = buckets->roots[b];
+    for (int depth = 0; depth < buckets->key_bits; depth++) {
+        path[depth] = node;
+        node = buckets->nodes[node].child[trie_side(buckets, key, frame, depth)];
+    }
+    path[buckets->key_bits] = node;
+
+    //Walk back up, dropping emptied nodes and recomputing the lowest frame of the rest from their children
+    for (int depth = buckets->key_bits; depth >= 0; depth--) {
+        TrieNode *t = &buckets->nodes[path[depth]];
+        t->count--;
+        if (t->count == 0) {
+            trie_node_free(buckets, path[depth]);
+            if (depth == 0) {
+                buckets->roots[b] = -1;
+                buckets->occupied &= ~(1ull << b);
+            } else {
+                buckets->nodes[path[depth - 1]].child[trie_side(buckets, key, frame, depth - 1)] = -1;
+            }
+        } else {
+            int left = t->child[0];
+            int right = t->child[1];
+            t->lowest_frame = left == -1 ? buckets->nodes[right].lowest_frame
+                            : right == -1 ? buckets->nodes[left].lowest_frame
+                            : buckets->nodes[left].lowest_frame < buckets->nodes[right].lowest_frame
+                                ? buckets->nodes[left].lowest_frame : buckets->nodes[right].lowest_frame;
+        }
+    }
+}
+
+static void expired_set(EpochBuckets *buckets, int frame) {
+    buckets->expired[frame >> 6] |= 1ull << (frame & 63);
+    buckets->expired_summary[frame >> 12] |= 1ull << ((frame >> 6) & 63);
+    buckets->expired_count++;
+}
+
+static void expired_clear(EpochBuckets *buckets, int frame) {
+    buckets->expired[frame >> 6] &= ~(1ull << (frame & 63));
+    if (buckets->expired[frame >> 6] == 0) {
+        buckets->expired_summary[frame >> 12] &= ~(1ull << ((frame >> 6) & 63));
+    }
+    buckets->expired_count--;
+}
+
+static int expired_lowest(const EpochBuckets *buckets) {
+    int s = 0;
+    while (buckets->expired_summary[s] == 0) {
+        s++;
+    }
+    int word = (s << 6) + __builtin_ctzll(buckets->expired_summary[s]);
+    return (word << 6) + __builtin_ctzll(buckets->expired[word]);
+}
+
+//Take a frame out of whichever bucket or set it is in, key is its stored register
+static void bucket_remove(EpochBuckets *buckets, int frame, unsigned int key, int epoch) {
+    int last = buckets->last_epoch[frame];
+    if (epoch - last >= buckets->n) {
+        expired_clear(buckets, frame);
+    } else {
+        bucket_unlink(buckets, last % buckets->n, key, frame);
+    }
+}
+
+//Free a trie, moving the frames at its leaves to the expired set
+static void trie_expire(EpochBuckets *buckets, int node, int depth, int frame) {
+    if (depth == buckets->key_bits) {
+        expired_set(buckets, frame);
+    } else {
+        int index_bit = depth >= buckets->n;
+        for (int side = 0; side < 2; side++) {
+            int child = buckets->nodes[node].child[side];
+            if (child != -1) {
+                trie_expire(buckets, child, depth + 1, index_bit ? frame << 1 | side : frame);
+            }
+        }
+    }
+    trie_node_free(buckets, node);
+}
+
+//Move every frame of bucket b to the expired set
+static void bucket_expire(EpochBuckets *buckets, int b) {
+    if (buckets->roots[b] != -1) {
+        trie_expire(buckets, buckets->roots[b], 0, 0);
+        buckets->roots[b] = -1;
+        buckets->occupied &= ~(1ull << b);
+    }
+}
+
+//Pick the frame to replace exactly as get_replacement_index would. Expired frames hold register 0, the
+//lowest, so the first of them is taken, or the clock hand when every frame has expired. Otherwise the oldest
+//live bucket holds the lowest registers, since the highest set bit of a register is the epoch of its last
+//reference. Live buckets run from (epoch + 1) % n round to epoch % n, so the occupancy mask is rotated to
+//start there. A bucket k places into that run has missed n - 1 - k shifts, so only the top k + 1 bits of its
+//stored registers are left: following the lowest branch for k + 1 levels reaches the frames holding the
+//lowest register, and the node keeps the first of them. When that node holds every frame all registers are
+//equal and the clock hand is used
+static int bucket_victim(const EpochBuckets *buckets, int epoch, int *clock_hand, int num_frames) {
+    int n = buckets->n;
+    if (buckets->expired_count > 0 && buckets->expired_count < num_frames) {
+        return expired_lowest(buckets);
+    }
+    if (buckets->expired_count == 0) {
+        int start = (epoch + 1) % n;
+        unsigned long long live = (1ull << n) - 1;  //n is at most 32
+        unsigned long long rotated = ((buckets->occupied >> start) | (buckets->occupied << (n - start))) & live;
+        int k = __builtin_ctzll(rotated);
+        int node = buckets->roots[(start + k) % n];
+        for (int depth = 0; depth <= k; depth++) {
+            const TrieNode *t = &buckets->nodes[node];
+            node = t->child[0] != -1 ? t->child[0] : t->child[1];
+        }
+        if (buckets->nodes[node].count < num_frames) {
+            return buckets->nodes[node].lowest_frame;
+        }
+    }
+    //All registers are equal so fall back to FIFO
+    int oldest_index = *clock_hand;
+    *clock_hand = (*clock_hand + 1) % num_frames;
+    return oldest_index;
+}
+
+//Simulate Second Chance with lazily aged registers, whatever m is. Each register is stored with the epoch of
+//its last update and the pending shifts are applied when it is read, and victims come from the epoch buckets
+//instead of a scan, at O(n + log frames) per reference. Page faults and write backs match
+//simulate_second_chance exactly
+int simulate_second_chance_lazy(SecondChanceContext *ctx, Page *listOfPages, int num_pages, int n, int m) {
+    int page_faults = 0;
+    int clock_hand = 0;
+    int epoch = 0;
+    int reference_count = 0;
+    unsigned int leftmost_bit = 1u << (n - 1);
+    unsigned int register_mask = n >= 32 ? ~0u : (1u << n) - 1;
+    int num_frames = ctx->num_frames;
+    int words = (num_frames + 63) / 64;
+    int summary_words = (words + 63) / 64;
+    ctx->write_back_count = 0;
+
+    PageTable table;
+    page_table_init(&table, num_frames);
+    EpochBuckets buckets;
+    buckets.n = n;
+    buckets.index_bits = 0;
+    while ((1 << buckets.index_bits) < num_frames) {
+        buckets.index_bits++;
+    }
+    buckets.key_bits = n + buckets.index_bits;
+    buckets.occupied = 0;
+    buckets.expired_count = 0;
+    buckets.node_capacity = 64;
+    buckets.free_node = 0;
+    buckets.nodes = malloc(buckets.node_capacity * sizeof(TrieNode));
+    buckets.roots = malloc(n * sizeof(int));
+    buckets.last_epoch = malloc(num_frames * sizeof(int));
+    buckets.expired = calloc(words, sizeof(unsigned long long));
+    buckets.expired_summary = calloc(summary_words, sizeof(unsigned long long));
+    if (buckets.nodes == NULL || buckets.roots == NULL || buckets.last_epoch == NULL ||
+        buckets.expired == NULL || buckets.expired_summary == NULL) {
+        perror("Failed to allocate memory");
+        exit(1);
+    }
+    for (int i = 0; i < buckets.node_capacity; i++) {
+        buckets.nodes[i].child[0] = i + 1 < buckets.node_capacity ? i + 1 : -1;
+    }
+    for (int b = 0; b < n; b++) {
+        buckets.roots[b] = -1;
+    }
+
+    //Empty frames have register 0, so they start out expired
+    for (int i = 0; i < num_frames; i++) {
+        ctx->page_numbers[i] = -1;
+        ctx->ref_registers[i] = 0;
+        ctx->dirty[i] = 0;
+        buckets.last_epoch[i] = -n;
+        expired_set(&buckets, i);
+    }
+
+    for (int i = 0; i < num_pages; i++) {
+        int page_number = listOfPages[i].page_number;
+        int dirty_bit = listOfPages[i].dirty;
+        int page_index = page_table_find(&table, page_number);
+        unsigned int value;
+
+        if (page_index == -1) {
+            page_faults++;
+            page_index = bucket_victim(&buckets, epoch, &clock_hand, num_frames);
+            if (ctx->dirty[page_index] == 1) {
+                ctx->write_back_count++;
             }
+            if (ctx->page_numbers[page_index] != -1) {
+                page_table_remove(&table, ctx->page_numbers[page_index]);
+            }
+            page_table_insert(&table, page_number, page_index);
+            ctx->page_numbers[page_index] = page_number;
+            value = leftmost_bit;
+        } else {
+            //Catch the register up on the shifts it missed before setting its leftmost bit
+            int pending = epoch - buckets.last_epoch[page_index];
+            unsigned int aged = pending >= 32 ? 0 : (ctx->ref_registers[page_index] >> pending) & register_mask;
+            value = aged | leftmost_bit;
+        }
+        ctx->dirty[page_index] = dirty_bit;
+        //A hit on a frame already referenced this epoch leaves its register and bucket as they are
+        if (buckets.last_epoch[page_index] != epoch || ctx->ref_registers[page_index] != value) {
+            bucket_remove(&buckets, page_index, ctx->ref_registers[page_index], epoch);
+            ctx->ref_registers[page_index] = value;
+            buckets.last_epoch[page_index] = epoch;
+            bucket_insert(&buckets, epoch % n, value, page_index);
+        }
+
+        //Every m references start a new epoch, whose bucket still holds the frames of n epochs ago
+        reference_count++;
+        if (reference_count == m) {
             reference_count = 0;
+            epoch++;
+            bucket_expire(&buckets, epoch % n);
+        }
+    }
+
+    free(buckets.nodes);
+    free(buckets.roots);
+    free(buckets.last_epoch);
+    free(buckets.expired);
+    free(buckets.expired_summary);
+    page_table_free(&table);
+    return page_faults;
+}
+
+//Function to allocate memory or exit with an error
+static void *checked_malloc(size_t size) {
+    void *memory = malloc(size);
+    if (memory == NULL) {
+        perror("Failed to allocate memory");
+        exit(1);
+    }
+    return memory;
+}
+
+//Doubly linked list of entries threaded through prev/next arrays, head is the newest entry
+typedef struct {
+    int head;
+    int tail;
+    int size;
+} EntryList;
+
+static void entry_list_init(EntryList *list) {
+    list->head = list->tail = -1;
+    list->size = 0;
+}
+
+static void entry_list_push_front(EntryList *list, int *prev, int *next, int entry) {
+    prev[entry] = -1;
+    next[entry] = list->head;
+    if (list->head == -1) {
+        list->tail = entry;
+    } else {
+        prev[list->head] = entry;
+    }
+    list->head = entry;
+    list->size++;
+}
+
+static void entry_list_unlink(EntryList *list, int *prev, int *next, int entry) {
+    if (prev[entry] == -1) {
+        list->head = next[entry];
+    } else {
+        next[prev[entry]] = next[entry];
+    }
+    if (next[entry] == -1) {
+        list->tail = prev[entry];
+    } else {
+        prev[next[entry]] = prev[entry];
+    }
+    list->size--;
+}
+
+//LIRS (Jiang and Zhang). Pages whose last two references were close (low inter-reference recency) are LIR
+//and always resident, the other resident pages are HIR and fill a small queue of about 1% of the frames.
+//The stack S orders recent pages by recency and its bottom is always LIR, so a page referenced again while
+//still in S was reused sooner than the bottom LIR page and takes its place. Pages evicted while in S stay
+//in it as non-resident entries, at most num_frames of them, oldest evicted dropped first.
+enum { LIRS_LIR, LIRS_HIR, LIRS_NONRESIDENT };
+
+typedef struct {
+    int *page_numbers;
+    int *status;        //LIRS_LIR, LIRS_HIR (resident) or LIRS_NONRESIDENT
+    int *dirty;
+    char *in_stack;
+    int *stack_prev;
+    int *stack_next;
+    EntryList stack;    //S, head is the most recent reference
+    int *queue_prev;
+    int *queue_next;
+    EntryList hir;      //Resident HIR pages, tail is the next victim
+    EntryList ghosts;   //Non-resident entries in order of eviction, tail is the oldest
+    int *free_entries;
+    int free_count;
+    PageTable table;
+    int lir_count;
+    int lir_capacity;
+    int resident_count;
+} Lirs;
+
+static void lirs_delete(Lirs *lirs, int entry) {
+    page_table_remove(&lirs->table, lirs->page_numbers[entry]);
+    lirs->free_entries[lirs->free_count++] = entry;
+}
+
+static void lirs_to_top(Lirs *lirs, int entry) {
+    if (lirs->in_stack[entry]) {
+        entry_list_unlink(&lirs->stack, lirs->stack_prev, lirs->stack_next, entry);
+    }
+    entry_list_push_front(&lirs->stack, lirs->stack_prev, lirs->stack_next, entry);
+    lirs->in_stack[entry] = 1;
+}
+
+//Stack pruning: drop HIR entries from the bottom of S until it is LIR again
+static void lirs_prune(Lirs *lirs) {
+    while (lirs->stack.tail != -1 && lirs->status[lirs->stack.tail] != LIRS_LIR) {
+        int entry = lirs->stack.tail;
+        entry_list_unlink(&lirs->stack, lirs->stack_prev, lirs->stack_next, entry);
+        lirs->in_stack[entry] = 0;
+        if (lirs->status[entry] == LIRS_NONRESIDENT) {
+            entry_list_unlink(&lirs->ghosts, lirs->queue_prev, lirs->queue_next, entry);
+            lirs_delete(lirs, entry);
+        }
+    }
+}
+
+//Function to turn the bottom LIR page of S into a resident HIR page, making room for a new LIR page
+static void lirs_demote_bottom(Lirs *lirs) {
+    int entry = lirs->stack.tail;
+    entry_list_unlink(&lirs->stack, lirs->stack_prev, lirs->stack_next, entry);
+    lirs->in_stack[entry] = 0;
+    lirs->status[entry] = LIRS_HIR;
+    entry_list_push_front(&lirs->hir, lirs->queue_prev, lirs->queue_next, entry);
+    lirs_prune(lirs);
+}
+
+//Simulate LIRS, amortized O(1) per reference: every entry is pruned from S at most once per reference.
+//Dirty bits follow the latest reference like in simulate_second_chance
+int simulate_lirs(SecondChanceContext *ctx, Page *listOfPages, int num_pages) {
+    int num_frames = ctx->num_frames;
+    int entries = 2 * num_frames + 2;  //Resident pages, ghosts and the page being loaded
+    int hir_capacity = num_frames / 100 > 1 ? num_frames / 100 : 1;
+    int page_faults = 0;
+    ctx->write_back_count = 0;
+
+    Lirs lirs;
+    lirs.page_numbers = checked_malloc(entries * sizeof(int));
+    lirs.status = checked_malloc(entries * sizeof(int));
+    lirs.dirty = checked_malloc(entries * sizeof(int));
+    lirs.in_stack = checked_malloc(entries);
+    lirs.stack_prev = checked_malloc(entries * sizeof(int));
+    lirs.stack_next = checked_malloc(entries * sizeof(int));
+    lirs.queue_prev = checked_malloc(entries * sizeof(int));
+    lirs.queue_next = checked_malloc(entries * sizeof(int));
+    lirs.free_entries = checked_malloc(entries * sizeof(int));
+    for (int i = 0; i < entries; i++) {
+        lirs.free_entries[i] = entries - 1 - i;
+    }
+    lirs.free_count = entries;
+    entry_list_init(&lirs.stack);
+    entry_list_init(&lirs.hir);
+    entry_list_init(&lirs.ghosts);
+    page_table_init(&lirs.table, entries);
+    lirs.lir_count = 0;
+    lirs.lir_capacity = num_frames - hir_capacity;  //0 with a single frame, then every page is HIR
+    lirs.resident_count = 0;
+
+    for (int i = 0; i < num_pages; i++) {
+        int page_number = listOfPages[i].page_number;
+        int dirty_bit = listOfPages[i].dirty;
+        int entry = page_table_find(&lirs.table, page_number);
+
+        if (entry != -1 && lirs.status[entry] == LIRS_LIR) {
+            lirs.dirty[entry] = dirty_bit;
+            lirs_to_top(&lirs, entry);
+            lirs_prune(&lirs);
+            continue;
+        }
+        if (entry != -1 && lirs.status[entry] == LIRS_HIR) {
+            lirs.dirty[entry] = dirty_bit;
+            entry_list_unlink(&lirs.hir, lirs.queue_prev, lirs.queue_next, entry);
+            if (lirs.in_stack[entry] && lirs.lir_capacity > 0) {
+                //Reused within the LIR set's recency, so it becomes LIR
+                lirs.status[entry] = LIRS_LIR;
+                lirs_to_top(&lirs, entry);
+                lirs_demote_bottom(&lirs);
+            } else {
+                lirs_to_top(&lirs, entry);
+                entry_list_push_front(&lirs.hir, lirs.queue_prev, lirs.queue_next, entry);
+            }
+            continue;
+        }
+
+        //Page fault, the victim is the oldest resident HIR page
+        page_faults++;
+        if (lirs.resident_count == num_frames) {
+            int victim = lirs.hir.tail;
+            entry_list_unlink(&lirs.hir, lirs.queue_prev, lirs.queue_next, victim);
+            if (lirs.dirty[victim] == 1) {
+                ctx->write_back_count++;
+            }
+            if (lirs.in_stack[victim]) {
+                lirs.status[victim] = LIRS_NONRESIDENT;
+                entry_list_push_front(&lirs.ghosts, lirs.queue_prev, lirs.queue_next, victim);
+            } else {
+                lirs_delete(&lirs, victim);
+            }
+            lirs.resident_count--;
+        }
+
+        if (entry == -1) {
+            entry = lirs.free_entries[--lirs.free_count];
+            lirs.page_numbers[entry] = page_number;
+            lirs.in_stack[entry] = 0;
+            page_table_insert(&lirs.table, page_number, entry);
+        } else {
+            entry_list_unlink(&lirs.ghosts, lirs.queue_prev, lirs.queue_next, entry);
+        }
+        lirs.dirty[entry] = dirty_bit;
+        lirs.resident_count++;
+
+        if (lirs.lir_count < lirs.lir_capacity) {
+            //Until the LIR set is full every page is LIR
+            lirs.status[entry] = LIRS_LIR;
+            lirs.lir_count++;
+            lirs_to_top(&lirs, entry);
+        } else if (lirs.in_stack[entry] && lirs.lir_capacity > 0) {
+            lirs.status[entry] = LIRS_LIR;
+            lirs_to_top(&lirs, entry);
+            lirs_demote_bottom(&lirs);
+        } else {
+            lirs.status[entry] = LIRS_HIR;
+            lirs_to_top(&lirs, entry);
+            entry_list_push_front(&lirs.hir, lirs.queue_prev, lirs.queue_next, entry);
+        }
+
+        //Bound the metadata: forget the ghost evicted longest ago
+        while (lirs.ghosts.size > num_frames) {
+            int ghost = lirs.ghosts.tail;
+            entry_list_unlink(&lirs.ghosts, lirs.queue_prev, lirs.queue_next, ghost);
+            entry_list_unlink(&lirs.stack, lirs.stack_prev, lirs.stack_next, ghost);
+            lirs_delete(&lirs, ghost);
+        }
+    }
+
+    free(lirs.page_numbers);
+    free(lirs.status);
+    free(lirs.dirty);
+    free(lirs.in_stack);
+    free(lirs.stack_prev);
+    free(lirs.stack_next);
+    free(lirs.queue_prev);
+    free(lirs.queue_next);
+    free(lirs.free_entries);
+    page_table_free(&lirs.table);
+    return page_faults;
+}
+
+//CLOCK-Pro (Jiang, Chen and Zhang), LIRS approximated with clock hands like get_replacement_index. Resident
+//pages are hot or cold and carry a reference bit, and cold pages that were evicted stay on the clock as
+//non-resident test entries. All entries share one circular list, new entries go just behind the hot hand.
+//  The cold hand evicts unreferenced cold pages, keeping them as test entries, and promotes referenced ones
+//  The hot hand clears reference bits and demotes unreferenced hot pages, keeping hot pages within
+//  num_frames - cold_target
+//  The test hand drops the oldest test entries, at most num_frames are kept
+//A fault on a test entry means the cold pages deserve more room so cold_target grows, a test entry dropped
+//without being referenced shrinks it.
+enum { CLOCK_PRO_HOT, CLOCK_PRO_COLD, CLOCK_PRO_TEST };
+
+typedef struct {
+    int *page_numbers;
+    int *status;       //CLOCK_PRO_HOT, CLOCK_PRO_COLD or CLOCK_PRO_TEST
+    int *referenced;
+    int *dirty;
+    int *prev;
+    int *next;         //Direction the hands move in
+    int *free_entries;
+    int free_count;
+    PageTable table;
+    int hand_hot;
+    int hand_cold;
+    int hand_test;
+    int hot_count;
+    int cold_count;    //Resident cold pages
+    int test_count;
+    int cold_target;
+    int num_frames;
+    int write_back_count;
+} ClockPro;
+
+static void clock_pro_insert(ClockPro *clock, int page_number, int status, int dirty_bit) {
+    int entry = clock->free_entries[--clock->free_count];
+    clock->page_numbers[entry] = page_number;
+    clock->status[entry] = status;
+    clock->referenced[entry] = 0;
+    clock->dirty[entry] = dirty_bit;
+    page_table_insert(&clock->table, page_number, entry);
+
+    if (clock->hand_hot == -1) {
+        clock->prev[entry] = clock->next[entry] = entry;
+        clock->hand_hot = clock->hand_cold = clock->hand_test = entry;
+        return;
+    }
+    int after = clock->hand_hot;
+    clock->prev[entry] = clock->prev[after];
+    clock->next[entry] = after;
+    clock->next[clock->prev[after]] = entry;
+    clock->prev[after] = entry;
+}
+
+//Function to take an entry off the clock, hands on it move on to the next entry
+static void clock_pro_delete(ClockPro *clock, int entry) {
+    int following = clock->next[entry] == entry ? -1 : clock->next[entry];
+    if (clock->hand_hot == entry) {
+        clock->hand_hot = following;
+    }
+    if (clock->hand_cold == entry) {
+        clock->hand_cold = following;
+    }
+    if (clock->hand_test == entry) {
+        clock->hand_test = following;
+    }
+    clock->next[clock->prev[entry]] = clock->next[entry];
+    clock->prev[clock->next[entry]] = clock->prev[entry];
+    page_table_remove(&clock->table, clock->page_numbers[entry]);
+    clock->free_entries[clock->free_count++] = entry;
+}
+
+static void clock_pro_run_hand_test(ClockPro *clock) {
+    int entry = clock->hand_test;
+    if (clock->status[entry] == CLOCK_PRO_TEST) {
+        //The test period ended without a reference
+        clock_pro_delete(clock, entry);
+        clock->test_count--;
+        if (clock->cold_target > 1) {
+            clock->cold_target--;
+        }
+    } else {
+        clock->hand_test = clock->next[entry];
+    }
+}
+
+static void clock_pro_run_hand_hot(ClockPro *clock) {
+    if (clock->hand_hot == clock->hand_test) {
+        clock_pro_run_hand_test(clock);  //The hot hand pushes the test hand along
+    }
+    int entry = clock->hand_hot;
+    if (clock->status[entry] == CLOCK_PRO_HOT) {
+        if (clock->referenced[entry]) {
+            clock->referenced[entry] = 0;
+        } else {
+            clock->status[entry] = CLOCK_PRO_COLD;
+            clock->hot_count--;
+            clock->cold_count++;
+        }
+    }
+    clock->hand_hot = clock->next[entry];
+}
+
+static void clock_pro_run_hand_cold(ClockPro *clock) {
+    int entry = clock->hand_cold;
+    clock->hand_cold = clock->next[entry];
+    if (clock->status[entry] == CLOCK_PRO_COLD) {
+        if (clock->referenced[entry]) {
+            //Referenced during its test period, so its reuse distance beats the hot pages'
+            clock->status[entry] = CLOCK_PRO_HOT;
+            clock->referenced[entry] = 0;
+            clock->cold_count--;
+            clock->hot_count++;
+        } else {
+            if (clock->dirty[entry] == 1) {
+                clock->write_back_count++;
+            }
+            clock->dirty[entry] = 0;
+            clock->status[entry] = CLOCK_PRO_TEST;
+            clock->cold_count--;
+            clock->test_count++;
+            while (clock->test_count > clock->num_frames) {
+                clock_pro_run_hand_test(clock);
+            }
+        }
+    }
+    while (clock->hot_count > clock->num_frames - clock->cold_target) {
+        clock_pro_run_hand_hot(clock);
+    }
+}
+
+//Simulate CLOCK-Pro, amortized O(1) per reference since every hand step retires a reference bit, a status
+//change or an entry. Dirty bits follow the latest reference like in simulate_second_chance
+int simulate_clock_pro(SecondChanceContext *ctx, Page *listOfPages, int num_pages) {
+    int num_frames = ctx->num_frames;
+    int entries = 2 * num_frames + 1;  //Resident pages, test entries and the page being loaded
+    int page_faults = 0;
+
+    ClockPro clock;
+    clock.page_numbers = checked_malloc(entries * sizeof(int));
+    clock.status = checked_malloc(entries * sizeof(int));
+    clock.referenced = checked_malloc(entries * sizeof(int));
+    clock.dirty = checked_malloc(entries * sizeof(int));
+    clock.prev = checked_malloc(entries * sizeof(int));
+    clock.next = checked_malloc(entries * sizeof(int));
+    clock.free_entries = checked_malloc(entries * sizeof(int));
+    for (int i = 0; i < entries; i++) {
+        clock.free_entries[i] = entries - 1 - i;
+    }
+    clock.free_count = entries;
+    page_table_init(&clock.table, entries);
+    clock.hand_hot = clock.hand_cold = clock.hand_test = -1;
+    clock.hot_count = clock.cold_count = clock.test_count = 0;
+    clock.cold_target = 1;  //Start like LIRS with nearly all frames for hot pages, test hits move room to cold ones
+    clock.num_frames = num_frames;
+    clock.write_back_count = 0;
+
+    for (int i = 0; i < num_pages; i++) {
+        int page_number = listOfPages[i].page_number;
+        int dirty_bit = listOfPages[i].dirty;
+        int entry = page_table_find(&clock.table, page_number);
+
+        if (entry != -1 && clock.status[entry] != CLOCK_PRO_TEST) {
+            clock.referenced[entry] = 1;
+            clock.dirty[entry] = dirty_bit;
+            continue;
+        }
+
+        page_faults++;
+        int status = CLOCK_PRO_COLD;
+        if (entry != -1) {
+            //Reused within its test period, the page comes back hot
+            if (clock.cold_target < num_frames - 1) {  //Always leave room for one hot page
+                clock.cold_target++;
+            }
+            clock_pro_delete(&clock, entry);
+            clock.test_count--;
+            status = CLOCK_PRO_HOT;
+        }
+        while (clock.hot_count + clock.cold_count >= num_frames) {
+            clock_pro_run_hand_cold(&clock);
+        }
+        clock_pro_insert(&clock, page_number, status, dirty_bit);
+        if (status == CLOCK_PRO_HOT) {
+            clock.hot_count++;
+        } else {
+            clock.cold_count++;
         }
     }
 
+    ctx->write_back_count = clock.write_back_count;
+    free(clock.page_numbers);
+    free(clock.status);
+    free(clock.referenced);
+    free(clock.dirty);
+    free(clock.prev);
+    free(clock.next);
+    free(clock.free_entries);
+    page_table_free(&clock.table);
     return page_faults;
 }
+
+//Either simulate_second_chance or simulate_second_chance_lazy
+typedef int (*SimulateFn)(SecondChanceContext *ctx, Page *listOfPages, int num_pages, int n, int m);
+
 //Experiment 1: Vary n from 1 to 32 with m = 10
-void run_experiment_vary_n(Page *listOfPages, int num_pages) {
+void run_experiment_vary_n(Page *listOfPages, int num_pages, SimulateFn simulate) {
     int m_fixed = 10;
+    SecondChanceContext ctx;
+    init_context(&ctx, MAX_FRAMES);
     printf("Experiment 1: Vary n (m = 10)\n");
     printf("+--------+--------------+-----------------+\n");
     printf("| n      | Page Faults   | Write Backs     |\n");
     printf("+--------+--------------+-----------------+\n");
 
     for (int n = 1; n <= 32; n++) {
-        int page_faults = simulate_second_chance(listOfPages, num_pages, n, m_fixed);
-        printf("| %-6d | %-12d | %-15d |\n", n, page_faults, write_back_count);
+        int page_faults = simulate(&ctx, listOfPages, num_pages, n, m_fixed);
+        printf("| %-6d | %-12d | %-15d |\n", n, page_faults, ctx.write_back_count);
     }
 
     printf("+--------+--------------+-----------------+\n");
+    free_context(&ctx);
 }
 
 //Experiment 2: Vary m from 1 to 100 with n = 8
-void run_experiment_vary_m(Page *listOfPages, int num_pages) {
+void run_experiment_vary_m(Page *listOfPages, int num_pages, SimulateFn simulate) {
     int n_fixed = 8;
+    SecondChanceContext ctx;
+    init_context(&ctx, MAX_FRAMES);
     printf("Experiment 2: Vary m (n = 8)\n");
     printf("+--------+--------------+-----------------+\n");
     printf("| m      | Page Faults   | Write Backs     |\n");
     printf("+--------+--------------+-----------------+\n");
 
     for (int m = 1; m <= 100; m++) {
-        int page_faults = simulate_second_chance(listOfPages, num_pages, n_fixed, m);
-        printf("| %-6d | %-12d | %-15d |\n", m, page_faults, write_back_count);
+        int page_faults = simulate(&ctx, listOfPages, num_pages, n_fixed, m);
+        printf("| %-6d | %-12d | %-15d |\n", m, page_faults, ctx.write_back_count);
     }
 
     printf("+--------+--------------+-----------------+\n");
+    free_context(&ctx);
 }
-int main() {
+//One point of the (n, m, frames) grid
+typedef struct {
+    int page_faults;
+    int write_backs;
+} GridResult;
+
+//Grid shared by the worker threads, points are numbered n-major, then m, then frame count
+typedef struct {
+    Page *listOfPages;
+    int num_pages;
+    int max_n;
+    int max_m;
+    int max_frames;
+    GridResult *results;
+    atomic_int next_point;  //Next point nobody has claimed yet
+} Grid;
+
+//Worker loop: claim grid points until the grid is exhausted, reusing one context for all of them
+void *grid_worker(void *arg) {
+    Grid *grid = arg;
+    int total = grid->max_n * grid->max_m * grid->max_frames;
+    SecondChanceContext ctx;
+    init_context(&ctx, grid->max_frames);
+
+    for (;;) {
+        int point = atomic_fetch_add(&grid->next_point, 1);
+        if (point >= total) {
+            break;
+        }
+        int frames = point % grid->max_frames + 1;
+        int m = point / grid->max_frames % grid->max_m + 1;
+        int n = point / (grid->max_frames * grid->max_m) + 1;
+
+        ctx.num_frames = frames;
+        grid->results[point].page_faults = simulate_second_chance(&ctx, grid->listOfPages, grid->num_pages, n, m);
+        grid->results[point].write_backs = ctx.write_back_count;
+    }
+
+    free_context(&ctx);
+    return NULL;
+}
+
+//Experiment 3: Vary n from 1 to 32, m from 1 to 100 and the frame count from 1 to max_frames on num_threads threads
+void run_experiment_grid(Page *listOfPages, int num_pages, int max_frames, int num_threads) {
+    Grid grid;
+    grid.listOfPages = listOfPages;
+    grid.num_pages = num_pages;
+    grid.max_n = 32;
+    grid.max_m = 100;
+    grid.max_frames = max_frames;
+    int total = grid.max_n * grid.max_m * grid.max_frames;
+    grid.results = malloc(total * sizeof(GridResult));
+    pthread_t *workers = malloc(num_threads * sizeof(pthread_t));
+    if (grid.results == NULL || workers == NULL) {
+        perror("Failed to allocate memory");
+        exit(1);
+    }
+    atomic_init(&grid.next_point, 0);
+
+    //The calling thread is one of the workers
+    int started = 0;
+    for (int t = 1; t < num_threads; t++) {
+        if (pthread_create(&workers[started], NULL, grid_worker, &grid) != 0) {
+            break;  //Carry on with the threads we have
+        }
+        started++;
+    }
+    grid_worker(&grid);
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    printf("Experiment 3: Vary n, m and frames\n");
+    printf("+--------+--------+--------+--------------+-----------------+\n");
+    printf("| n      | m      | Frames | Page Faults  | Write Backs     |\n");
+    printf("+--------+--------+--------+--------------+-----------------+\n");
+    for (int point = 0; point < total; point++) {
+        printf("| %-6d | %-6d | %-6d | %-12d | %-15d |\n",
+               point / (grid.max_frames * grid.max_m) + 1,
+               point / grid.max_frames % grid.max_m + 1,
+               point % grid.max_frames + 1,
+               grid.results[point].page_faults,
+               grid.results[point].write_backs);
+    }
+    printf("+--------+--------+--------+--------------+-----------------+\n");
+
+    free(workers);
+    free(grid.results);
+}
+
+//Experiment 4: Vary the number of frames, aging (n = 8, m = 10) against LIRS and CLOCK-Pro
+void run_experiment_vary_frames(Page *listOfPages, int num_pages, int max_frames) {
+    printf("Experiment 4: Vary frames, aging (n = 8, m = 10) against LIRS and CLOCK-Pro\n");
+    printf("+--------+--------------+--------------+--------------+--------------+--------------+--------------+\n");
+    printf("| Frames | Aging Faults | Aging WB     | LIRS Faults  | LIRS WB      | CPro Faults  | CPro WB      |\n");
+    printf("+--------+--------------+--------------+--------------+--------------+--------------+--------------+\n");
+
+    for (int frames = 1; frames <= max_frames; frames++) {
+        SecondChanceContext ctx;
+        init_context(&ctx, frames);
+        int aging_faults = simulate_second_chance(&ctx, listOfPages, num_pages, 8, 10);
+        int aging_write_backs = ctx.write_back_count;
+        int lirs_faults = simulate_lirs(&ctx, listOfPages, num_pages);
+        int lirs_write_backs = ctx.write_back_count;
+        int clock_pro_faults = simulate_clock_pro(&ctx, listOfPages, num_pages);
+        printf("| %-6d | %-12d | %-12d | %-12d | %-12d | %-12d | %-12d |\n", frames, aging_faults,
+               aging_write_backs, lirs_faults, lirs_write_backs, clock_pro_faults, ctx.write_back_count);
+        free_context(&ctx);
+    }
+
+    printf("+--------+--------------+--------------+--------------+--------------+--------------+--------------+\n");
+}
+//Function to parse a count argument, returns 0 unless it is a whole number of at least 1
+static int parse_count(const char *text, int *value) {
+    char *end;
+    long parsed = strtol(text, &end, 10);
+    if (*end != '\0' || parsed < 1 || parsed > INT_MAX) {
+        return 0;
+    }
+    *value = (int)parsed;
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
     FILE *file;
     char line[256];
     Page *listOfPages = NULL;  // Pointer for dynamic allocation
     int pageCount = 0;
 
+    // Check the mode and its arguments before reading the input
+    const char *mode = argc > 1 ? argv[1] : "";
+    int max_frames = MAX_FRAMES;
+    int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    int max_args = strcmp(mode, "grid") == 0 ? 4 : strcmp(mode, "frames") == 0 ? 3 : 2;
+    int valid = (argc == 1 || strcmp(mode, "lazy") == 0 || max_args > 2) && argc <= max_args;
+    if (valid && argc > 2) {
+        valid = parse_count(argv[2], &max_frames);
+    }
+    if (valid && argc > 3) {
+        valid = parse_count(argv[3], &num_threads);
+    }
+    if (!valid) {
+        fprintf(stderr, "Usage: %s [lazy | frames [max frames] | grid [max frames] [threads]]\n", argv[0]);
+        fprintf(stderr, "Frame and thread counts must be whole numbers of at least 1.\n");
+        return 1;
+    }
+
+    // Pick the vector width of the frame table kernels
+    detect_simd();
+
     // Open CSV file for reading
     file = fopen("inputfile.txt", "r");
     if (file == NULL) {
@@ -168,8 +1302,7 @@ int main() {
 
     // Allocate memory for the pages
     listOfPages = malloc(pageCount * sizeof(Page));
-    frames = malloc(MAX_FRAMES * sizeof(Page));  // Allocate memory for frames
-    if (listOfPages == NULL || frames == NULL) {
+    if (listOfPages == NULL) {
         perror("Failed to allocate memory");
         fclose(file);
         return 1;
@@ -193,15 +1326,25 @@ int main() {
 
     fclose(file);  // Close the file after reading
 
-    // Run experiment 1: Fix m = 10, vary n
-    run_experiment_vary_n(listOfPages, pageCount);
+    if (strcmp(mode, "frames") == 0) {
+        // Run experiment 4: aging, LIRS and CLOCK-Pro over frames 1..MAX_FRAMES, optionally "frames <max frames>"
+        run_experiment_vary_frames(listOfPages, index, max_frames);
+    } else if (strcmp(mode, "grid") == 0) {
+        // Run experiment 3: the full (n, m, frames) grid, optionally "grid <max frames> <threads>"
+        run_experiment_grid(listOfPages, index, max_frames, num_threads);
+    } else {
+        // "lazy" runs the same experiments with lazily aged registers
+        SimulateFn simulate = strcmp(mode, "lazy") == 0 ? simulate_second_chance_lazy : simulate_second_chance;
 
-    // Run experiment 2: Fix n = 8, vary m
-    run_experiment_vary_m(listOfPages, pageCount);
+        // Run experiment 1: Fix m = 10, vary n
+        run_experiment_vary_n(listOfPages, index, simulate);
+
+        // Run experiment 2: Fix n = 8, vary m
+        run_experiment_vary_m(listOfPages, index, simulate);
+    }
 
     
     free(listOfPages);
-    free(frames);
 
     return 0;
 }
@@ -0,0 +1,387 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+// Build with -lm
+
+// Reproducible synthetic traces for pageReplacement and the standalone simulators
+// The same options and seed always give the same trace, on any machine.
+//   traceGenerator [--refs N] [--universe U] [--dirty R] [--seed S] [--pattern P]
+//                  [--alpha A] [--window W] [--phase L] [--processes P] [--binary] > trace
+// Patterns:
+//   zipf   pages drawn from a Zipf(alpha) distribution over the universe, page 0 is the most popular
+//   loop   pages 0..W-1 in order, over and over
+//   scan   one sequential pass over the universe after another
+//   shift  pages drawn uniformly from a working set of W pages that moves every L references
+//   mixed  a Zipf hot set interleaved with a loop and a scan (60/25/15 percent of the references)
+// The CSV output has a header line like the course input files. --binary writes the fixed PRTB format of
+// pageReplacement instead, which loads without parsing.
+// With --processes P every reference comes from one of P processes picked uniformly at random, each running
+// the pattern on its own address space of the universe's size, and a PID column (0..P-1) is added.
+
+typedef enum {
+    PATTERN_ZIPF,
+    PATTERN_LOOP,
+    PATTERN_SCAN,
+    PATTERN_SHIFT,
+    PATTERN_MIXED
+} Pattern;
+
+// xorshift64* seeded through splitmix64, so nearby seeds still give unrelated streams
+typedef struct {
+    unsigned long long state;
+} Random;
+
+void randomSeed(Random *random, unsigned long long seed) {
+    unsigned long long z = seed + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    random->state = z != 0 ? z : 1; // xorshift must not start at 0
+}
+
+static inline unsigned long long randomNext(Random *random) {
+    random->state ^= random->state >> 12;
+    random->state ^= random->state << 25;
+    random->state ^= random->state >> 27;
+    return random->state * 0x2545f4914f6cdd1dull;
+}
+
+// Uniform double in [0, 1)
+static inline double randomDouble(Random *random) {
+    return (randomNext(random) >> 11) * 0x1.0p-53;
+}
+
+// Uniform integer in [0, bound)
+static inline long long randomBelow(Random *random, long long bound) {
+    return (long long)(randomDouble(random) * bound);
+}
+
+// Zipf sampler using rejection-inversion (Hörmann and Derflinger), O(1) per sample with no table,
+// so universes of any size cost nothing to set up
+typedef struct {
+    double exponent;
+    long long elements;
+    double hIntegralX1;
+    double hIntegralElements;
+    double s;
+} Zipf;
+
+// log1p(x) / x and expm1(x) / x, with their series near 0 where the division loses precision
+static double helper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+static double helper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+}
+
+static double zipfH(const Zipf *zipf, double x) {
+    return exp(-zipf->exponent * log(x));
+}
+
+static double zipfHIntegral(const Zipf *zipf, double x) {
+    double logX = log(x);
+    return helper2((1.0 - zipf->exponent) * logX) * logX;
+}
+
+static double zipfHIntegralInverse(const Zipf *zipf, double x) {
+    double t = x * (1.0 - zipf->exponent);
+    if (t < -1.0) {
+        t = -1.0; // Rounding can push t just past the pole
+    }
+    return exp(helper1(t) * x);
+}
+
+void zipfInit(Zipf *zipf, long long elements, double exponent) {
+    zipf->exponent = exponent;
+    zipf->elements = elements;
+    zipf->hIntegralX1 = zipfHIntegral(zipf, 1.5) - 1.0;
+    zipf->hIntegralElements = zipfHIntegral(zipf, elements + 0.5);
+    zipf->s = 2.0 - zipfHIntegralInverse(zipf, zipfHIntegral(zipf, 2.5) - zipfH(zipf, 2.0));
+}
+
+// Rank in 1..elements, rank 1 the most likely
+long long zipfSample(const Zipf *zipf, Random *random) {
+    for (;;) {
+        double u = zipf->hIntegralElements + randomDouble(random) * (zipf->hIntegralX1 - zipf->hIntegralElements);
+        double x = zipfHIntegralInverse(zipf, u);
+        long long k = (long long)(x + 0.5);
+        if (k < 1) {
+            k = 1;
+        } else if (k > zipf->elements) {
+            k = zipf->elements;
+        }
+        if (k - x <= zipf->s || u >= zipfHIntegral(zipf, k + 0.5) - zipfH(zipf, (double)k)) {
+            return k;
+        }
+    }
+}
+
+// Options and running state of the generator
+typedef struct {
+    Pattern pattern;
+    long long universe;
+    long long window;
+    long long phase;
+    Zipf zipf;
+    long long loopPosition;
+    long long scanPosition;
+    long long shiftBase;
+    long long references; // References made so far, which place the shift phases
+} Generator;
+
+static inline long long nextPage(Generator *generator, Random *random) {
+    long long reference = generator->references++;
+    switch (generator->pattern) {
+    case PATTERN_ZIPF:
+        return zipfSample(&generator->zipf, random) - 1;
+    case PATTERN_LOOP: {
+        long long page = generator->loopPosition;
+        generator->loopPosition = page + 1 == generator->window ? 0 : page + 1;
+        return page;
+    }
+    case PATTERN_SCAN: {
+        long long page = generator->scanPosition;
+        generator->scanPosition = page + 1 == generator->universe ? 0 : page + 1;
+        return page;
+    }
+    case PATTERN_SHIFT:
+        if (reference % generator->phase == 0) {
+            generator->shiftBase = randomBelow(random, generator->universe - generator->window + 1);
+        }
+        return generator->shiftBase + randomBelow(random, generator->window);
+    case PATTERN_MIXED: {
+        double choice = randomDouble(random);
+        if (choice < 0.60) {
+            return zipfSample(&generator->zipf, random) - 1;
+        }
+        if (choice < 0.85) {
+            long long page = generator->loopPosition;
+            generator->loopPosition = page + 1 == generator->window ? 0 : page + 1;
+            return page;
+        }
+        long long page = generator->scanPosition;
+        generator->scanPosition = page + 1 == generator->universe ? 0 : page + 1;
+        return page;
+    }
+    }
+    return 0;
+}
+
+// Output is formatted by hand into a large buffer, printf would dominate a billion-reference trace
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+typedef struct {
+    char data[OUTPUT_BUFFER_SIZE];
+    size_t length;
+} Output;
+
+static void outputFlush(Output *output) {
+    if (fwrite(output->data, 1, output->length, stdout) != output->length) {
+        perror("Error: Cannot write the trace");
+        exit(EXIT_FAILURE);
+    }
+    output->length = 0;
+}
+
+static inline char *outputNumber(char *out, long long value) {
+    char digits[24];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+// Write one "page,dirty" line, or "page,dirty,pid" when pid is not negative
+static inline void outputCsv(Output *output, long long page, int dirty, long long pid) {
+    if (output->length + 48 > OUTPUT_BUFFER_SIZE) {
+        outputFlush(output);
+    }
+    char *out = outputNumber(output->data + output->length, page);
+    *out++ = ',';
+    *out++ = (char)('0' + dirty);
+    if (pid >= 0) {
+        *out++ = ',';
+        out = outputNumber(out, pid);
+    }
+    *out++ = '\n';
+    output->length = out - output->data;
+}
+
+static inline void outputBytes(Output *output, unsigned long long value, int bytes) {
+    if (output->length + bytes > OUTPUT_BUFFER_SIZE) {
+        outputFlush(output);
+    }
+    for (int i = 0; i < bytes; i++) {
+        output->data[output->length++] = (char)(value >> (8 * i));
+    }
+}
+
+// Parse a count such as 1000000 or 1e6
+static bool parseCount(const char *text, long long minimum, long long maximum, long long *value) {
+    char *end;
+    double parsed = strtod(text, &end);
+    if (*end != '\0' || parsed < minimum || parsed > maximum || parsed != (long long)parsed) {
+        return false;
+    }
+    *value = (long long)parsed;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    long long refs = 1000000;
+    long long universe = 1000;
+    long long window = -1;
+    long long phase = -1;
+    double dirtyRatio = 0.3;
+    double alpha = 0.99;
+    unsigned long long seed = 1;
+    Pattern pattern = PATTERN_ZIPF;
+    long long processes = 1;
+    bool binary = false;
+
+    for (int arg = 1; arg < argc; arg++) {
+        bool hasValue = arg + 1 < argc;
+        if (strcmp(argv[arg], "--refs") == 0 && hasValue) {
+            if (!parseCount(argv[++arg], 1, 1000000000000LL, &refs)) {
+                fprintf(stderr, "Error: --refs expects a positive count.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--universe") == 0 && hasValue) {
+            if (!parseCount(argv[++arg], 1, INT32_MAX, &universe)) {
+                fprintf(stderr, "Error: --universe expects a page count between 1 and 2^31-1.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--window") == 0 && hasValue) {
+            if (!parseCount(argv[++arg], 1, INT32_MAX, &window)) {
+                fprintf(stderr, "Error: --window expects a positive page count.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--phase") == 0 && hasValue) {
+            if (!parseCount(argv[++arg], 1, 1000000000000LL, &phase)) {
+                fprintf(stderr, "Error: --phase expects a positive reference count.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--dirty") == 0 && hasValue) {
+            char *end;
+            dirtyRatio = strtod(argv[++arg], &end);
+            if (*end != '\0' || !(dirtyRatio >= 0.0 && dirtyRatio <= 1.0)) {
+                fprintf(stderr, "Error: --dirty expects a ratio between 0 and 1.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--alpha") == 0 && hasValue) {
+            char *end;
+            alpha = strtod(argv[++arg], &end);
+            if (*end != '\0' || !(alpha > 0.0 && alpha <= 10.0)) {
+                fprintf(stderr, "Error: --alpha expects an exponent between 0 and 10.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++arg], NULL, 10);
+        } else if (strcmp(argv[arg], "--pattern") == 0 && hasValue) {
+            const char *names[] = {"zipf", "loop", "scan", "shift", "mixed"};
+            const char *name = argv[++arg];
+            int found = -1;
+            for (int i = 0; i < 5; i++) {
+                if (strcmp(name, names[i]) == 0) {
+                    found = i;
+                }
+            }
+            if (found < 0) {
+                fprintf(stderr, "Error: --pattern expects zipf, loop, scan, shift or mixed.\n");
+                return EXIT_FAILURE;
+            }
+            pattern = (Pattern)found;
+        } else if (strcmp(argv[arg], "--processes") == 0 && hasValue) {
+            if (!parseCount(argv[++arg], 1, 1000000, &processes)) {
+                fprintf(stderr, "Error: --processes expects a process count between 1 and 1000000.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--binary") == 0) {
+            binary = true;
+        } else {
+            fprintf(stderr, "Error: Unknown option %s (traceGenerator [--refs N] [--universe U] [--dirty R] [--seed S] [--pattern zipf|loop|scan|shift|mixed] [--alpha A] [--window W] [--phase L] [--processes P] [--binary]).\n", argv[arg]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The working set defaults to a tenth of the universe and moves ten times over the trace
+    if (window < 0) {
+        window = universe / 10 > 0 ? universe / 10 : 1;
+    }
+    if (window > universe) {
+        window = universe;
+    }
+    if (phase < 0) {
+        phase = refs / 10 > 0 ? refs / 10 : 1;
+    }
+    if (binary && refs > UINT32_MAX) {
+        fprintf(stderr, "Error: A binary trace holds at most 2^32-1 references.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Every process runs its own copy of the pattern
+    Generator *generators = malloc(processes * sizeof(Generator));
+    if (generators == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return EXIT_FAILURE;
+    }
+    generators[0] = (Generator){pattern, universe, window, phase, {0, 0, 0, 0, 0}, 0, 0, 0, 0};
+    zipfInit(&generators[0].zipf, universe, alpha);
+    for (long long process = 1; process < processes; process++) {
+        generators[process] = generators[0];
+    }
+    Random random;
+    randomSeed(&random, seed);
+    // The dirty bits and the processes come from their own streams so changing --dirty or --processes
+    // leaves the other choices unchanged
+    Random dirtyRandom;
+    randomSeed(&dirtyRandom, ~seed);
+    Random processRandom;
+    randomSeed(&processRandom, seed ^ 0xa5a5a5a5a5a5a5a5ull);
+    bool pids = processes > 1;
+
+    static Output output;
+    if (binary) {
+        // Header of the fixed encoding, see the binary trace format in pageReplacement.c
+        outputBytes(&output, 0x42545250, 4); // "PRTB"
+        outputBytes(&output, 1, 1);          // Version
+        outputBytes(&output, 0, 1);          // TRACE_FIXED
+        outputBytes(&output, pids, 2);       // TRACE_FLAG_PIDS and reserved
+        outputBytes(&output, (unsigned long long)refs, 8);
+        outputBytes(&output, 65536, 4);
+        outputBytes(&output, 0, 12);         // Reserved and no block index
+    } else {
+        output.length = strlen(strcpy(output.data, pids ? "Page,Dirty,Pid\n" : "Page,Dirty\n"));
+    }
+
+    for (long long reference = 0; reference < refs; reference++) {
+        long long process = pids ? randomBelow(&processRandom, processes) : 0;
+        long long page = nextPage(&generators[process], &random);
+        int dirty = randomDouble(&dirtyRandom) < dirtyRatio;
+        if (binary) {
+            outputBytes(&output, (unsigned long long)page << 1 | dirty, 4);
+            if (pids) {
+                outputBytes(&output, (unsigned long long)process, 4);
+            }
+        } else {
+            outputCsv(&output, page, dirty, pids ? process : -1);
+        }
+    }
+    outputFlush(&output);
+    free(generators);
+
+    if (fflush(stdout) != 0) {
+        perror("Error: Cannot write the trace");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}